@@ -0,0 +1,116 @@
+#ifndef ARENA_RESOURCE_H
+#define ARENA_RESOURCE_H
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+
+//! @brief Memory resource carving aligned blocks out of large chunks.
+
+//! Blocks are handed out from a few large chunks obtained from
+//! `upstream`, each starting on an `alignment` boundary and padded
+//! to a multiple of `alignment` bytes, so that columns can be read
+//! with aligned SIMD loads up to the padding and columns allocated
+//! one after the other are adjacent in memory.
+//! With `huge_pages` set, chunks are aligned to 2 MiB and marked
+//! for transparent huge pages, which cuts TLB misses in sweeps
+//! over tens of millions of particles.
+//!
+//! A chunk is returned to `upstream` when all its blocks have been
+//! freed; the last block of a chunk is reused in place when freed.
+//! Use it as the memory resource of `particles_t`,
+//!
+//!     arena_resource_t arena;
+//!     particles_t ptcls (n, {}, {"m"}, grid, &arena);
+//!
+//! and `particles_t::reserve` to grow all columns in one go.
+//! The resource must outlive all columns allocated from it.
+class
+arena_resource_t : public std::pmr::memory_resource {
+
+public:
+
+  //! default alignment and padding of blocks, one cache line
+  //! and the width of the widest SIMD registers.
+  static constexpr std::size_t default_alignment = 64;
+
+  //! size and alignment of huge pages.
+  static constexpr std::size_t huge_page_size = std::size_t (2) << 20;
+
+  //! @param chunk_bytes_ size of chunks, larger blocks get a chunk of their own.
+  //! @param alignment_ alignment and padding of blocks, a power of two.
+  //! @param huge_pages_ back chunks with transparent huge pages.
+  //! @param upstream_ resource chunks are obtained from.
+  explicit
+  arena_resource_t (std::size_t chunk_bytes_ = std::size_t (64) << 20,
+		    std::size_t alignment_ = default_alignment,
+		    bool huge_pages_ = false,
+		    std::pmr::memory_resource *upstream_
+		    = std::pmr::get_default_resource ());
+
+  arena_resource_t (const arena_resource_t &) = delete;
+
+  arena_resource_t &
+  operator= (const arena_resource_t &) = delete;
+
+  //! Returns all chunks to `upstream`.
+  ~arena_resource_t ();
+
+  //! alignment and padding of blocks.
+  std::size_t
+  alignment () const
+  { return align; };
+
+  //! number of bytes obtained from `upstream`.
+  std::size_t
+  bytes_reserved () const;
+
+  //! number of bytes in blocks currently allocated, padding included.
+  std::size_t
+  bytes_allocated () const;
+
+  //! number of chunks currently held.
+  std::size_t
+  num_chunks () const;
+
+private:
+
+  struct
+  chunk_t {
+    std::size_t size;       //!< bytes in the chunk.
+    std::size_t used;       //!< offset of the first free byte.
+    std::size_t live;       //!< number of blocks allocated.
+    bool        current;    //!< whether new blocks are taken from here.
+  };
+
+  void *
+  do_allocate (std::size_t bytes, std::size_t alignment) override;
+
+  void
+  do_deallocate (void *p, std::size_t bytes, std::size_t alignment) override;
+
+  bool
+  do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+  { return this == &other; };
+
+  char *
+  new_chunk (std::size_t bytes, bool current);
+
+  void
+  release (char *base, chunk_t &c);
+
+  std::size_t                    chunk_bytes;
+  std::size_t                    align;
+  bool                           huge_pages;
+  std::pmr::memory_resource     *upstream;
+
+  mutable std::mutex             mtx;
+  std::map<char *, chunk_t>      chunks;    //!< chunk base -> chunk.
+  char                          *head = nullptr;  //!< current chunk.
+  std::size_t                    reserved = 0;
+  std::size_t                    allocated = 0;
+
+};
+
+#endif /* ARENA_RESOURCE_H */
@@ -0,0 +1,114 @@
+#ifndef ASCII_FORMAT_H
+#define ASCII_FORMAT_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <tracer.h>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//! @brief Helpers for fast formatting of large ascii dumps.
+
+//! Numbers are formatted with `std::to_chars` into plain
+//! character buffers rather than through `std::ostream`,
+//! large outputs are split in chunks that are formatted in
+//! parallel (when OpenMP is enabled) and written to the
+//! stream in their original order.
+namespace ASCII_FORMAT {
+
+  //! number of significant digits used for `double` values,
+  //! same as `std::setprecision (16)` on an `std::ostream`.
+  constexpr int precision = 16;
+
+  //! default number of items formatted by a thread in one chunk.
+  constexpr std::size_t default_chunk_size = 1 << 14;
+
+  //! @brief Append a `double` to a buffer.
+
+  //! The result is the same text that `os << std::setprecision (16) << v`
+  //! would produce with default stream flags.
+  inline void
+  append (std::string & buf, double v) {
+    char tmp[32];
+    auto res = std::to_chars (tmp, tmp + sizeof (tmp), v,
+			      std::chars_format::general, precision);
+    buf.append (tmp, res.ptr);
+  }
+
+  //! @brief Append an integer to a buffer.
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T>>
+  append (std::string & buf, T v) {
+    char tmp[24];
+    auto res = std::to_chars (tmp, tmp + sizeof (tmp), v);
+    buf.append (tmp, res.ptr);
+  }
+
+  //! @brief Format the items `0 ... n-1` and write them to `os`.
+
+  //! `fmt (buf, ii)` must append the text for item `ii` to `buf`.
+  //! Items are grouped in chunks of `chunk` consecutive entries, each
+  //! chunk is formatted by one thread into its own buffer and buffers
+  //! are written out in order, so the output does not depend on the
+  //! number of threads. Only a bounded number of chunks is kept in
+  //! memory at any time.
+  template <typename F>
+  void
+  write_chunked (std::ostream & os, std::size_t n, F && fmt,
+		 std::size_t chunk = default_chunk_size) {
+
+    if (n == 0)
+      return;
+
+    std::size_t nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads ();
+#endif
+
+    const std::size_t chunks_per_block = 4 * nthreads;
+    const std::size_t block = chunks_per_block * chunk;
+    std::vector<std::string> bufs (chunks_per_block);
+
+    for (std::size_t start = 0; start < n; start += block) {
+
+      const std::size_t nchunks =
+	(std::min (n - start, block) + chunk - 1) / chunk;
+
+#pragma omp parallel for schedule(static, 1)
+      for (std::size_t ic = 0; ic < nchunks; ++ic) {
+	QUADGRID_SPAN ("format_chunk", "io");
+	auto & buf = bufs[ic];
+	buf.clear ();
+	const std::size_t first = start + ic * chunk;
+	const std::size_t last = std::min (first + chunk, n);
+	for (std::size_t ii = first; ii < last; ++ii)
+	  fmt (buf, ii);
+      }
+
+      QUADGRID_SPAN ("write_block", "io");
+      for (std::size_t ic = 0; ic < nchunks; ++ic)
+	os.write (bufs[ic].data (), bufs[ic].size ());
+    }
+  }
+
+  //! @brief Write a sequence of numbers separated (and terminated)
+  //! by a blank space.
+  template <typename T>
+  void
+  write_row (std::ostream & os, const T * data, std::size_t n) {
+    write_chunked (os, n, [data] (std::string & buf, std::size_t ii) {
+      append (buf, data[ii]);
+      buf += ' ';
+    });
+  }
+
+}
+
+#endif /* ASCII_FORMAT_H */
@@ -0,0 +1,190 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <string>
+#include <thread>
+#include <tracer.h>
+#include <vector>
+
+//! @brief Background writer for simulation output.
+
+//! Each export request waits for a free slot in the queue, takes a
+//! snapshot (a copy) of the requested grid fields or particle
+//! columns, then queues a job that serializes the snapshot and
+//! writes the file from a background thread, so the caller can go
+//! on modifying its data while output is in progress.
+//! At most `max_pending` snapshots are queued (plus the one being
+//! written), further requests block until a slot is free, which
+//! bounds the extra memory used by the writer.
+//! Invoke `flush ()` at the end of the run (or before reading back
+//! any of the files), the destructor also waits for all pending
+//! jobs to complete.
+//! The grid objects passed to the export methods must not be
+//! resized or destroyed until the corresponding output is written.
+class
+async_writer_t {
+
+public:
+
+  //! @brief Start the background thread.
+  //! @param max_pending maximum number of snapshots waiting to be written.
+  explicit
+  async_writer_t (std::size_t max_pending = 2);
+
+  //! Delete copy constructor.
+  async_writer_t (const async_writer_t &) = delete;
+
+  //! Delete assignment operator.
+  async_writer_t &
+  operator= (const async_writer_t &) = delete;
+
+  //! Write all pending output and stop the background thread.
+  ~async_writer_t ();
+
+  //! @brief Queue a generic job.
+
+  //! `job` must own (capture by value) all the data it needs.
+  //! Blocks while the queue is full.
+  void
+  submit (std::function<void ()> job);
+
+  //! @brief Wait until all queued jobs are completed.
+
+  //! If any job has thrown an exception since the last call,
+  //! the first such exception is rethrown here.
+  void
+  flush ();
+
+  //! number of jobs queued or being written.
+  std::size_t
+  pending () const;
+
+  //! @brief Asynchronous version of `quadgrid_t::vtk_export`.
+
+  //! Only fields listed in `names` are written (all of them if
+  //! `names` is empty).
+  template <class T>
+  void
+  vtk_export (const quadgrid_t<T> &grid, const std::string &filename,
+	      const std::map<std::string, T> &f,
+	      const std::vector<std::string> &names = {}) {
+    enqueue ([&] {
+      auto snap = snapshot (f, names);
+      return [&grid, filename, snap] {
+	grid.vtk_export (filename.c_str (), *snap);
+      };
+    });
+  }
+
+  //! @brief Asynchronous version of `quadgrid_t::octave_ascii_export`.
+
+  //! Only fields listed in `names` are written (all of them if
+  //! `names` is empty).
+  template <class T>
+  void
+  octave_ascii_export (const quadgrid_t<T> &grid, const std::string &filename,
+		       const std::map<std::string, T> &f,
+		       const std::vector<std::string> &names = {}) {
+    enqueue ([&] {
+      auto snap = snapshot (f, names);
+      return [&grid, filename, snap] {
+	grid.octave_ascii_export (filename.c_str (), *snap);
+      };
+    });
+  }
+
+  //! @brief Asynchronous version of `particles_t::print`.
+
+  //! Positions are always written, only the properties listed in
+  //! `dpropnames` and `ipropnames` are written (all of them if
+  //! both lists are empty).
+  template <particles_t::output_format fmt>
+  void
+  print (const particles_t &p, const std::string &filename,
+	 const std::vector<std::string> &dpropnames = {},
+	 const std::vector<std::string> &ipropnames = {}) {
+    enqueue ([&] {
+      auto snap = snapshot (p, dpropnames, ipropnames);
+      return [filename, snap] {
+	std::ofstream os (filename);
+	snap->print<fmt> (os);
+	os.close ();
+      };
+    });
+  }
+
+private:
+
+  //! Wait for a free slot in the queue, then take the snapshot
+  //! by invoking `make_job` and queue the job it returns.
+  template <typename F>
+  void
+  enqueue (F &&make_job) {
+    {
+      QUADGRID_SPAN ("async_wait_slot", "io");
+      acquire_slot ();
+    }
+    try {
+      QUADGRID_SPAN ("async_snapshot", "io");
+      push (make_job ());
+    } catch (...) {
+      release_slot ();
+      throw;
+    }
+  }
+
+  void
+  acquire_slot ();
+
+  void
+  release_slot ();
+
+  void
+  push (std::function<void ()> job);
+
+  template <class T>
+  static std::shared_ptr<const std::map<std::string, T>>
+  snapshot (const std::map<std::string, T> &f,
+	    const std::vector<std::string> &names) {
+    if (names.empty ())
+      return std::make_shared<const std::map<std::string, T>> (f);
+    auto snap = std::make_shared<std::map<std::string, T>> ();
+    for (auto const & ii : names)
+      snap->emplace (ii, f.at (ii));
+    return snap;
+  }
+
+  static std::shared_ptr<const particles_t>
+  snapshot (const particles_t &p,
+	    const std::vector<std::string> &dpropnames,
+	    const std::vector<std::string> &ipropnames);
+
+  void
+  run ();
+
+  const std::size_t                   max_pending;
+  std::deque<std::function<void ()>>  queue;
+  std::size_t                         reserved;
+  bool                                busy;
+  bool                                stop;
+  std::exception_ptr                  error;
+  mutable std::mutex                  mtx;
+  std::condition_variable             not_full;
+  std::condition_variable             not_empty;
+  std::condition_variable             idle;
+  std::thread                         worker;
+
+};
+
+#endif /* ASYNC_WRITER_H */
@@ -0,0 +1,226 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <quadgrid_cpp.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct particles_t;
+
+//! @brief Binary checkpoint/restart file for particles and grid fields.
+
+//! A checkpoint file is self-describing and consists of
+//!
+//! * a fixed size header (`header_t`) with a magic string, format
+//!   version, byte order tag, grid properties and particle count,
+//! * a directory with one fixed size entry (`entry_t`) per column,
+//!   giving its name, kind, element type and position in the file,
+//! * the raw column data, each column starting at an offset that
+//!   is a multiple of `checkpoint_t::alignment` bytes.
+//!
+//! Reading a checkpoint maps the file in memory via `mmap`,
+//! columns can then be accessed in place (zero-copy) via
+//! `checkpoint_t::data` or copied with a single `memcpy` into a
+//! `particles_t` object via the corresponding constructor.
+class
+checkpoint_t {
+
+public:
+
+  //! alignment in bytes of the start of each column in the file.
+  static constexpr std::size_t alignment = 64;
+
+  //! maximum length of a column name, including terminating null.
+  static constexpr std::size_t name_length = 80;
+
+  //! format version written in the header.
+  static constexpr std::uint32_t version = 1;
+
+  //! Kind of data stored in a column.
+  enum class
+  column_kind : std::uint32_t {
+    x = 0,          //!< x-coordinates of particles.
+    y = 1,          //!< y-coordinates of particles.
+    dprop = 2,      //!< an entry of particles_t::dprops.
+    iprop = 3,      //!< an entry of particles_t::iprops.
+    grid_var = 4    //!< a nodal grid field.
+  };
+
+  //! Type of the entries of a column.
+  enum class
+  elem_type : std::uint32_t {
+    floating = 0,   //!< IEEE floating point number.
+    integer = 1     //!< signed two's complement integer.
+  };
+
+  //! On-disk file header.
+  struct
+  header_t {
+    char          magic[8];          //!< always `"QGCHKPT"`.
+    std::uint32_t version;           //!< format version.
+    std::uint32_t byte_order;        //!< `0x01020304` as written by the producer.
+    std::uint64_t num_particles;     //!< number of particles.
+    std::int64_t  numrows;           //!< grid rows.
+    std::int64_t  numcols;           //!< grid columns.
+    double        hx;                //!< grid spacing in x-direction.
+    double        hy;                //!< grid spacing in y-direction.
+    std::uint64_t num_columns;       //!< number of entries in the directory.
+    std::uint64_t directory_offset;  //!< offset of the directory in bytes.
+    std::uint64_t file_size;         //!< total size of the file in bytes.
+    char          reserved[48];      //!< padding, set to zero.
+  };
+
+  //! On-disk directory entry.
+  struct
+  entry_t {
+    char          name[name_length]; //!< null-terminated column name.
+    column_kind   kind;              //!< what the column represents.
+    elem_type     type;              //!< type of the entries.
+    std::uint32_t elem_size;         //!< size in bytes of each entry.
+    std::uint32_t reserved;          //!< padding, set to zero.
+    std::uint64_t offset;            //!< offset of the data in bytes.
+    std::uint64_t count;             //!< number of entries.
+    char          padding[16];       //!< padding, set to zero.
+  };
+
+  static_assert (sizeof (header_t) == 128, "unexpected checkpoint header size");
+  static_assert (sizeof (entry_t) == 128, "unexpected checkpoint entry size");
+
+  //! @brief Write a checkpoint file.
+
+  //! Stores grid properties, particle positions, all entries of
+  //! `dprops` and `iprops` and the grid fields in `vars`.
+  //! Throws `std::runtime_error` if the file cannot be written.
+  static void
+  write (const char *filename, const particles_t &p,
+	 const std::map<std::string, std::vector<double>> &vars = {});
+
+  //! @brief Open and map a checkpoint file.
+
+  //! The header and directory are validated, throws
+  //! `std::runtime_error` if the file is not a valid checkpoint.
+  explicit
+  checkpoint_t (const char *filename);
+
+  //! Delete copy constructor.
+  checkpoint_t (const checkpoint_t &) = delete;
+
+  //! Delete assignment operator.
+  checkpoint_t &
+  operator= (const checkpoint_t &) = delete;
+
+  //! Unmap the file.
+  ~checkpoint_t ();
+
+  //! @brief Set sizes of `grid` to those stored in the checkpoint.
+  template <class T>
+  void
+  set_grid (quadgrid_t<T> &grid) const {
+    grid.set_sizes (header ().numrows, header ().numcols,
+		    header ().hx, header ().hy);
+  }
+
+  //! the file header.
+  const header_t &
+  header () const
+  { return *static_cast<const header_t *> (base); };
+
+  //! number of particles stored in the file.
+  std::size_t
+  num_particles () const
+  { return header ().num_particles; };
+
+  //! the column directory.
+  const std::vector<entry_t> &
+  columns () const
+  { return directory; };
+
+  //! @brief Find a column, return `nullptr` if not present.
+  const entry_t *
+  find (column_kind kind, const std::string &name = "") const;
+
+  //! @brief Zero-copy access to the data of a column.
+
+  //! The returned pointer is valid as long as the
+  //! checkpoint_t object exists. Throws `std::out_of_range` if
+  //! the column does not exist and `std::runtime_error` if its
+  //! entries are not of size `sizeof (T)`.
+  template <typename T>
+  const T *
+  data (column_kind kind, const std::string &name = "") const {
+    const entry_t &e = at (kind, name);
+    if (e.elem_size != sizeof (T))
+      throw std::runtime_error ("checkpoint column \"" + name
+				+ "\" has unexpected element size");
+    return reinterpret_cast<const T *> (static_cast<const char *> (base)
+					+ e.offset);
+  }
+
+  //! @brief Copy a column into a vector (one `memcpy` if the
+  //! element sizes match, a converting copy otherwise).
+  template <typename V>
+  void
+  copy (column_kind kind, const std::string &name, V &v) const;
+
+  //! @brief Copy all grid fields into a map.
+  std::map<std::string, std::vector<double>>
+  grid_vars () const;
+
+private:
+
+  const entry_t &
+  at (column_kind kind, const std::string &name) const;
+
+  void                 *base;
+  std::size_t           length;
+  std::vector<entry_t>  directory;
+
+};
+
+
+template <typename V>
+void
+checkpoint_t::copy (column_kind kind, const std::string &name, V &v) const {
+
+  using value_t = typename V::value_type;
+  const entry_t &e = at (kind, name);
+  const char *src = static_cast<const char *> (base) + e.offset;
+
+  v.resize (e.count);
+  if (e.elem_size == sizeof (value_t)
+      && std::is_integral_v<value_t> == (e.type == elem_type::integer)) {
+    std::memcpy (v.data (), src, e.count * sizeof (value_t));
+    return;
+  }
+
+  switch (e.elem_size) {
+  case 4 :
+    if (e.type == elem_type::integer)
+      std::copy_n (reinterpret_cast<const std::int32_t *> (src),
+		   e.count, v.begin ());
+    else
+      std::copy_n (reinterpret_cast<const float *> (src),
+		   e.count, v.begin ());
+    break;
+  case 8 :
+    if (e.type == elem_type::integer)
+      std::copy_n (reinterpret_cast<const std::int64_t *> (src),
+		   e.count, v.begin ());
+    else
+      std::copy_n (reinterpret_cast<const double *> (src),
+		   e.count, v.begin ());
+    break;
+  default :
+    throw std::runtime_error ("checkpoint column \"" + name
+			      + "\" has unsupported element size");
+  }
+}
+
+#endif /* CHECKPOINT_H */
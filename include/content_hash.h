@@ -0,0 +1,67 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//! @brief Hashes of the contents of buffers, used to detect changes
+//! (e.g. of fields between time steps, or of the particles a mass
+//! matrix was assembled from), not meant for hash tables.
+namespace CONTENT_HASH {
+
+  //! initial value of a hash.
+  constexpr std::uint64_t offset_basis = 14695981039346656037ull;
+
+  //! mix a 64 bit word into hash `h`, FNV-1a on words rather
+  //! than bytes, with the high bits folded back so that they affect
+  //! later words as well.
+  inline std::uint64_t
+  hash_word (std::uint64_t w, std::uint64_t h) {
+    h = (h ^ w) * 1099511628211ull;
+    return h ^ (h >> 32);
+  }
+
+  //! hash of a block of memory.
+  inline std::uint64_t
+  hash_bytes (const void *data, std::size_t n,
+	      std::uint64_t h = offset_basis) {
+    const unsigned char *c = static_cast<const unsigned char *> (data);
+    std::size_t ii = 0;
+    for (; ii + sizeof (std::uint64_t) <= n; ii += sizeof (std::uint64_t)) {
+      std::uint64_t w;
+      std::memcpy (&w, c + ii, sizeof (w));
+      h = hash_word (w, h);
+    }
+    for (; ii < n; ++ii)
+      h = hash_word (c[ii], h);
+    return hash_word (n, h);
+  }
+
+  //! hash of every `stride`-th element of `v`.
+  template <typename T, typename A>
+  std::uint64_t
+  hash_vector (const std::vector<T, A> &v, std::uint64_t h,
+	       std::size_t stride = 1) {
+    static_assert (sizeof (T) <= sizeof (std::uint64_t),
+		   "elements must fit a 64 bit word");
+    if (stride == 1)
+      return hash_bytes (v.data (), v.size () * sizeof (T), h);
+    for (std::size_t ii = 0; ii < v.size (); ii += stride) {
+      std::uint64_t w = 0;
+      std::memcpy (&w, &v[ii], sizeof (T));
+      h = hash_word (w, h);
+    }
+    return hash_word (v.size (), h);
+  }
+
+  inline std::uint64_t
+  hash_string (const std::string &s, std::uint64_t h) {
+    return hash_bytes (s.c_str (), s.size () + 1, h);
+  }
+
+}
+
+#endif
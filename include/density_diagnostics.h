@@ -0,0 +1,68 @@
+#ifndef DENSITY_DIAGNOSTICS_H
+#define DENSITY_DIAGNOSTICS_H
+
+#include <cstdint>
+#include <json.hpp>
+#include <vector>
+
+//! @brief Particle density and work imbalance statistics.
+
+//! Computed by `particles_t::density_diagnostics ()` from the
+//! grid/particles connectivity, so it is only meaningful if
+//! `init_particle_mesh ()` was invoked after particles last moved.
+//! The per-cell counts are laid out as the cells of the grid and can
+//! be exported as a cell field via `quadgrid_t::vtk_export`.
+struct
+density_diagnostics_t {
+
+  //! number of particles in each cell, indexed by global cell index.
+  std::vector<double>        counts;
+
+  //! @brief Histogram of particles per cell in powers of two.
+
+  //! `histogram[0]` is the number of empty cells, `histogram[k]`
+  //! for `k > 0` the number of cells with a particle count in
+  //! [2^(k-1), 2^k).
+  std::vector<std::int64_t>  histogram;
+
+  std::int64_t  num_cells = 0;        //!< number of cells of the grid.
+  std::int64_t  num_particles = 0;    //!< number of binned particles.
+  std::int64_t  min_count = 0;        //!< minimum number of particles per cell.
+  std::int64_t  max_count = 0;        //!< maximum number of particles per cell.
+  double        mean_count = 0.;      //!< mean number of particles per cell.
+  double        empty_fraction = 0.;  //!< fraction of cells with no particles.
+
+  //! @brief Particles handled by each of `num_parts` workers, if
+  //! cells are split in contiguous blocks of equal size, as a static
+  //! schedule over the cell sweep (or a block partition of the grid
+  //! among ranks) would do.
+  std::vector<std::int64_t>  part_load;
+
+  //! @brief Estimated work imbalance, maximum over mean of
+  //! `part_load`: 1 means perfect balance, `num_parts` means all
+  //! the work is done by a single worker.
+  double        imbalance = 1.;
+
+  //! @brief Imbalance of the number of particles among MPI ranks,
+  //! only computed if requested, 1 otherwise.
+  double        rank_imbalance = 1.;
+
+};
+
+//! @brief Adaptor to allow implicit conversion from
+//! `density_diagnostics_t` to `json`, per-cell counts are omitted.
+inline void
+to_json (nlohmann::json &j, const density_diagnostics_t &d) {
+  j = nlohmann::json{{"num_cells", d.num_cells},
+		     {"num_particles", d.num_particles},
+		     {"min_count", d.min_count},
+		     {"max_count", d.max_count},
+		     {"mean_count", d.mean_count},
+		     {"empty_fraction", d.empty_fraction},
+		     {"histogram", d.histogram},
+		     {"part_load", d.part_load},
+		     {"imbalance", d.imbalance},
+		     {"rank_imbalance", d.rank_imbalance}};
+}
+
+#endif /* DENSITY_DIAGNOSTICS_H */
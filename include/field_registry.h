@@ -0,0 +1,210 @@
+#ifndef FIELD_REGISTRY_H
+#define FIELD_REGISTRY_H
+
+#include <arena_resource.h>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <memory_resource>
+#include <quadgrid_cpp.h>
+#include <string>
+#include <vector>
+
+//! @brief Nodal fields owned by a grid, accessed through handles.
+
+//! Fields are registered by name once, with `add`, and sized to the
+//! nodes of the grid; their storage is carved out of an
+//! `arena_resource_t`, so each field starts on a 64 byte boundary
+//! and all fields lie next to each other, and it is placed by
+//! first touch (see numa_placement.h). Transfers take handles rather
+//! than names, so a typo is caught once, by `handle`, instead of
+//! silently inserting an empty field.
+//!
+//! `zero` does not clear fields right away: the next `p2g` into a
+//! field clears each node the first time it is hit and afterwards
+//! only the nodes written by earlier scatters and not hit again, so
+//! the usual
+//!
+//!     fields.zero ({hm, hv});
+//!     ptcls.p2g (fields, {"m", "vx"}, {hm, hv});
+//!
+//! costs one pass over the particles instead of a sweep over all
+//! nodes of each field followed by the scatter. Any other access
+//! to a field with a zeroing pending clears it first.
+//!
+//! A field may have several components (e.g. both components of a
+//! velocity), stored interleaved node by node: component `k` of
+//! node `n` is `values[n * components + k]`, so a transfer computes
+//! the node index and shape function once for all components.
+class
+field_registry_t {
+
+public:
+
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+  //! datatype of the storage of a field.
+  using field_t = std::pmr::vector<double>;
+
+  //! @brief Handle to a field, valid for the lifetime of the registry.
+  struct
+  handle_t {
+    std::size_t id;
+  };
+
+  //! @param grid_ grid the fields are defined on, sizes must be set.
+  //! @param upstream resource the arena takes memory from.
+  explicit
+  field_registry_t (const quadgrid_t<std::vector<double>> &grid_,
+		    std::pmr::memory_resource *upstream
+		    = std::pmr::get_default_resource ());
+
+  field_registry_t (const field_registry_t &) = delete;
+
+  field_registry_t &
+  operator= (const field_registry_t &) = delete;
+
+  //! @brief Register a field set to zero, or get the handle of an
+  //! existing field with the same name.
+
+  //! Throws `std::invalid_argument` if a field named `name` exists
+  //! with a different number of components.
+  //! @param name name of the field.
+  //! @param components number of values per node.
+  handle_t
+  add (const std::string &name, int components = 1);
+
+  //! @brief Handle of field `name`, throws `std::out_of_range`
+  //! if there is no such field.
+  handle_t
+  handle (const std::string &name) const;
+
+  //! whether a field named `name` is registered.
+  bool
+  contains (const std::string &name) const
+  { return index.count (name) > 0; };
+
+  //! name of the field of handle `h`.
+  const std::string &
+  name (handle_t h) const
+  { return fields.at (h.id).name; };
+
+  //! number of values per node of the field of handle `h`.
+  int
+  components (handle_t h) const
+  { return fields.at (h.id).components; };
+
+  //! number of fields.
+  std::size_t
+  size () const
+  { return fields.size (); };
+
+  //! number of nodes of each field.
+  idx_t
+  num_nodes () const
+  { return nnodes; };
+
+  //! grid the fields are defined on.
+  const quadgrid_t<std::vector<double>> &
+  get_grid () const
+  { return grid; };
+
+  //! @brief Set fields to zero, deferred to the next scatter into
+  //! each field or to the next access.
+  void
+  zero (std::initializer_list<handle_t> hs);
+
+  //! @brief Set all fields to zero, deferred as for `zero`.
+  void
+  zero_all ();
+
+  //! whether zeroing of field `h` is still pending.
+  bool
+  zero_pending (handle_t h) const
+  { return fields.at (h.id).pending; };
+
+  //! @brief Values of field `h` for reading and writing.
+
+  //! Any node may be written, so the next zeroing of the field
+  //! clears all nodes rather than only those written by scatters.
+  //! The reference must not be kept across a `zero`: the pending
+  //! zeroing is applied by the next access, after which writes
+  //! through an older reference are not tracked and may survive the
+  //! next zeroing. Use `values` to only read a field.
+  field_t &
+  operator[] (handle_t h);
+
+  //! @brief Values of field `h` for reading, as `values`.
+  const field_t &
+  operator[] (handle_t h) const;
+
+  //! @brief Values of field `h` for reading.
+
+  //! Unlike the non-const `operator[]`, reading does not make the
+  //! next zeroing clear all nodes.
+  const field_t &
+  values (handle_t h) const;
+
+  //! @brief Copy all fields into `vars`, e.g. for `write_vtk`,
+  //! component `k` of a field with several components as
+  //! `name_k`.
+  void
+  copy_to (std::map<std::string, std::vector<double>> &vars) const;
+
+  //! @brief Start a scatter into field `h`.
+
+  //! Returns a pointer to the values of the field and sets `fused`
+  //! if a zeroing is pending: then each node must be cleared the
+  //! first time `first_hit` returns true for it. For use by the
+  //! transfers of `particles_t`.
+  double *
+  begin_scatter (handle_t h, bool &fused);
+
+  //! @brief Whether node `inode` is hit for the first time in the
+  //! current fused scatter.
+  bool
+  first_hit (idx_t inode) {
+    const std::uint64_t bit = std::uint64_t (1) << (inode & 63);
+    std::uint64_t &word = hits[inode >> 6];
+    const bool first = (word & bit) == 0;
+    word |= bit;
+    return first;
+  };
+
+  //! @brief End a scatter into field `h` that visited `cells`.
+  void
+  end_scatter (handle_t h, const std::vector<idx_t> &cells);
+
+private:
+
+  struct
+  entry_t {
+    std::string          name;
+    int                  components;
+    field_t              values;
+    bool                 pending;     //!< zeroing pending.
+    bool                 all_dirty;   //!< written outside of scatters.
+    std::vector<idx_t>   dirty;       //!< sorted cells written by scatters.
+  };
+
+  //! apply a pending zeroing of `e` now.
+  void
+  flush (entry_t &e) const;
+
+  //! clear the nodes of `cells`, those hit by the last fused
+  //! scatter if `skip_hits`.
+  void
+  clear_cells (entry_t &e, const std::vector<idx_t> &cells,
+	       bool skip_hits) const;
+
+  const quadgrid_t<std::vector<double>> &grid;
+  idx_t                                  nnodes;
+  arena_resource_t                       arena;
+  mutable std::vector<entry_t>           fields;
+  std::map<std::string, std::size_t>     index;
+  std::vector<std::uint64_t>             hits;   //!< nodes hit in a fused scatter.
+
+};
+
+#endif /* FIELD_REGISTRY_H */
@@ -0,0 +1,224 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <json.hpp>
+#include <tracer.h>
+
+//! @brief Phases of the library for which timers and counters
+//! are recorded.
+enum class
+phase_t : int {
+  init_particle_mesh = 0,
+  p2g,
+  p2gd,
+  g2p,
+  g2pd,
+  build_mass,
+  remove_in_region,
+  print_csv,
+  print_octave_ascii,
+  print_json,
+  checkpoint_write,
+  vtk_export,
+  octave_ascii_export,
+  num_phases             //!< number of phases, not a phase.
+};
+
+//! @brief Statistics recorded for one phase.
+struct
+phase_stats_t {
+  double         wall_time = 0.;  //!< total wall time in seconds.
+  std::uint64_t  calls = 0;       //!< number of calls.
+  std::uint64_t  particles = 0;   //!< particles processed (once per field).
+  std::uint64_t  bytes = 0;       //!< bytes written.
+  std::uint64_t  cells = 0;       //!< cells visited (once per field).
+};
+
+//! @brief Per-object collection of timers and counters.
+
+//! Counters only exist if the library is compiled with the
+//! `QUADGRID_INSTRUMENT` macro defined, otherwise the class is empty,
+//! the instrumentation macros expand to nothing and all statistics
+//! read as zero. Counters are atomic, so objects may be used (e.g.
+//! for output) from several threads at the same time.
+class
+instrumentation_t {
+
+public:
+
+  //! @brief Accumulator used while a phase is running.
+  struct
+  counters_t {
+    std::atomic<std::uint64_t> nanoseconds{0};
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> particles{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> cells{0};
+  };
+
+  //! @brief RAII timer for one call of a phase.
+  class
+  scoped_phase_t {
+
+  public:
+
+    scoped_phase_t (counters_t &c_)
+      : c (c_), start (std::chrono::steady_clock::now ()) { };
+
+    ~scoped_phase_t () {
+      auto stop = std::chrono::steady_clock::now ();
+      c.nanoseconds.fetch_add
+	(std::chrono::duration_cast<std::chrono::nanoseconds>
+	 (stop - start).count (), std::memory_order_relaxed);
+      c.calls.fetch_add (1, std::memory_order_relaxed);
+    };
+
+    void
+    add_particles (std::uint64_t n)
+    { c.particles.fetch_add (n, std::memory_order_relaxed); };
+
+    void
+    add_bytes (std::uint64_t n)
+    { c.bytes.fetch_add (n, std::memory_order_relaxed); };
+
+    void
+    add_cells (std::uint64_t n)
+    { c.cells.fetch_add (n, std::memory_order_relaxed); };
+
+  private:
+
+    counters_t &c;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  instrumentation_t () = default;
+
+#ifdef QUADGRID_INSTRUMENT
+  //! Copies take a snapshot of the counters.
+  instrumentation_t (const instrumentation_t &other)
+  { *this = other; };
+
+  instrumentation_t &
+  operator= (const instrumentation_t &other) {
+    for (int ii = 0; ii < num_phases; ++ii) {
+      auto & to = counters[ii];
+      auto const & from = other.counters[ii];
+      to.nanoseconds = from.nanoseconds.load ();
+      to.calls = from.calls.load ();
+      to.particles = from.particles.load ();
+      to.bytes = from.bytes.load ();
+      to.cells = from.cells.load ();
+    }
+    return *this;
+  };
+
+  //! accumulator for phase `p`, used by the instrumentation macros.
+  counters_t &
+  operator[] (phase_t p)
+  { return counters[static_cast<int> (p)]; };
+
+  //! @brief Statistics recorded so far for phase `p`.
+  phase_stats_t
+  get (phase_t p) const {
+    auto const & c = counters[static_cast<int> (p)];
+    phase_stats_t s;
+    s.wall_time = c.nanoseconds.load () * 1.0e-9;
+    s.calls = c.calls.load ();
+    s.particles = c.particles.load ();
+    s.bytes = c.bytes.load ();
+    s.cells = c.cells.load ();
+    return s;
+  };
+#else
+  //! @brief Statistics recorded so far for phase `p`, always zero.
+  phase_stats_t
+  get (phase_t) const
+  { return phase_stats_t (); };
+#endif
+
+  //! @brief Set all counters to zero.
+  void
+  reset ()
+  { *this = instrumentation_t (); };
+
+  //! @brief Name of a phase, as used in the json output.
+  static const char *
+  name (phase_t p) {
+    static const char *names[num_phases] = {
+      "init_particle_mesh", "p2g", "p2gd", "g2p", "g2pd", "build_mass",
+      "remove_in_region", "print_csv", "print_octave_ascii", "print_json",
+      "checkpoint_write", "vtk_export", "octave_ascii_export"
+    };
+    return names[static_cast<int> (p)];
+  };
+
+  //! @brief Whether counters are updated in this build.
+  static constexpr bool
+  enabled () {
+#ifdef QUADGRID_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+  };
+
+private:
+
+  static constexpr int num_phases = static_cast<int> (phase_t::num_phases);
+#ifdef QUADGRID_INSTRUMENT
+  std::array<counters_t, num_phases> counters;
+#endif
+
+};
+
+//! @brief Adaptor to allow implicit conversion from
+//! `phase_stats_t` to `json`.
+inline void
+to_json (nlohmann::json &j, const phase_stats_t &s) {
+  j = nlohmann::json{{"wall_time", s.wall_time},
+		     {"calls", s.calls},
+		     {"particles", s.particles},
+		     {"bytes", s.bytes},
+		     {"cells", s.cells}};
+}
+
+//! @brief Adaptor to allow implicit conversion from
+//! `instrumentation_t` to `json`, only phases that were
+//! called at least once are listed.
+inline void
+to_json (nlohmann::json &j, const instrumentation_t &s) {
+  j = nlohmann::json::object ();
+  for (int ii = 0; ii < static_cast<int> (phase_t::num_phases); ++ii) {
+    auto p = static_cast<phase_t> (ii);
+    auto st = s.get (p);
+    if (st.calls > 0)
+      j[instrumentation_t::name (p)] = st;
+  }
+}
+
+//! @name Instrumentation macros
+//! `QUADGRID_PHASE (stats, phase)` times the rest of the enclosing
+//! scope as a call of `phase`, `QUADGRID_COUNT (what, n)` adds `n`
+//! to the `what` counter (`particles`, `bytes` or `cells`) of the
+//! phase being timed in the current scope. If `QUADGRID_TRACE` is
+//! defined, `QUADGRID_PHASE` also records the scope as a span of
+//! the event tracer.
+//! @{
+#ifdef QUADGRID_INSTRUMENT
+#define QUADGRID_PHASE_TIMER_(stats, phase)				\
+  instrumentation_t::scoped_phase_t quadgrid_phase_ ((stats)[phase])
+#define QUADGRID_COUNT(what, n)	quadgrid_phase_.add_##what (n)
+#else
+#define QUADGRID_PHASE_TIMER_(stats, phase)
+#define QUADGRID_COUNT(what, n)
+#endif
+#define QUADGRID_PHASE(stats, phase)					\
+  QUADGRID_PHASE_TIMER_(stats, phase);					\
+  QUADGRID_SPAN (instrumentation_t::name (phase), "phase")
+//! @}
+
+#endif /* INSTRUMENTATION_H */
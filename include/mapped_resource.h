@@ -0,0 +1,105 @@
+#ifndef MAPPED_RESOURCE_H
+#define MAPPED_RESOURCE_H
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+
+//! @brief Memory resource backed by memory mapped files.
+
+//! Each allocation of at least `min_bytes` bytes is placed in its own
+//! file, created in `directory` and unlinked right away, and mapped
+//! with `MAP_SHARED`: pages are written back to the file rather than
+//! to swap, so columns larger than the available RAM can be used,
+//! and the file disappears when the mapping is released (or the
+//! process exits). Smaller allocations are forwarded to `upstream`.
+//!
+//! Use it as the memory resource of `particles_t` to keep
+//! positions and property columns on disk,
+//!
+//!     mapped_resource_t mr ("/scratch");
+//!     particles_t ptcls (n, {}, {"m"}, grid, &mr);
+//!
+//! the resource must outlive all columns allocated from it.
+class
+mapped_resource_t : public std::pmr::memory_resource {
+
+public:
+
+  //! access pattern hints, see `madvise (2)`.
+  enum class
+  advice_t {
+    normal,      //!< no special treatment.
+    sequential,  //!< read ahead aggressively, free pages soon after access.
+    random,      //!< no read ahead.
+    willneed,    //!< start reading pages in.
+    dontneed     //!< pages may be dropped from memory.
+  };
+
+  //! @param directory_ where backing files are created.
+  //! @param min_bytes_ smaller allocations are served by `upstream_`.
+  //! @param advice_ hint applied to every new mapping.
+  //! @param upstream_ resource for small allocations.
+  explicit
+  mapped_resource_t (const std::string &directory_ = ".",
+		     std::size_t min_bytes_ = std::size_t (1) << 20,
+		     advice_t advice_ = advice_t::sequential,
+		     std::pmr::memory_resource *upstream_
+		     = std::pmr::get_default_resource ());
+
+  mapped_resource_t (const mapped_resource_t &) = delete;
+
+  mapped_resource_t &
+  operator= (const mapped_resource_t &) = delete;
+
+  //! Unmaps all mappings still allocated.
+  ~mapped_resource_t ();
+
+  //! @brief Apply `a` to the pages spanning `bytes` bytes from `p`.
+
+  //! Works for any memory, useful to switch a column to `random`
+  //! before gathers in unsorted order, or to `dontneed` once a
+  //! sweep is over.
+  static void
+  advise (const void *p, std::size_t bytes, advice_t a);
+
+  //! @brief Apply `a` to the storage of vector `v`.
+  template <class V>
+  static void
+  advise (const V &v, advice_t a)
+  { advise (v.data (), v.capacity () * sizeof (typename V::value_type), a); };
+
+  //! number of bytes currently mapped.
+  std::size_t
+  bytes_mapped () const;
+
+  //! number of mappings currently allocated.
+  std::size_t
+  num_mappings () const;
+
+private:
+
+  void *
+  do_allocate (std::size_t bytes, std::size_t alignment) override;
+
+  void
+  do_deallocate (void *p, std::size_t bytes, std::size_t alignment) override;
+
+  bool
+  do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+  { return this == &other; };
+
+  std::string                    directory;
+  std::size_t                    min_bytes;
+  advice_t                       advice;
+  std::pmr::memory_resource     *upstream;
+
+  mutable std::mutex             mtx;
+  std::map<void *, std::size_t>  mappings;  //!< address -> mapped length.
+  std::size_t                    mapped = 0;
+
+};
+
+#endif /* MAPPED_RESOURCE_H */
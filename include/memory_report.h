@@ -0,0 +1,150 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <json.hpp>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! @brief Breakdown of the memory held by an object.
+
+//! Each entry reports the bytes actually `used` by some data (e.g.
+//! `size ()` elements of a vector) and those `reserved` for it (e.g.
+//! `capacity ()` elements), the difference being slack that could be
+//! released. Entries are grouped in categories (positions,
+//! properties, binning index, ...) to ease sizing of large runs.
+//! Sizes of heap-allocated nodes of associative containers are
+//! estimates, as they depend on the standard library and allocator.
+struct
+memory_report_t {
+
+  //! One entry of the report.
+  struct
+  item_t {
+    std::string  category;  //!< group the entry belongs to.
+    std::string  name;      //!< name of the data.
+    std::size_t  used;      //!< bytes in use.
+    std::size_t  reserved;  //!< bytes allocated.
+  };
+
+  std::vector<item_t> items;  //!< entries of the report.
+
+  //! @brief Add an entry.
+  void
+  add (const std::string &category, const std::string &name,
+       std::size_t used, std::size_t reserved)
+  { items.push_back (item_t{category, name, used, reserved}); };
+
+  //! @brief Add an entry for the elements of a vector.
+  template <typename V>
+  void
+  add_vector (const std::string &category, const std::string &name,
+	      const V &v) {
+    add (category, name, v.size () * sizeof (typename V::value_type),
+	 v.capacity () * sizeof (typename V::value_type));
+  };
+
+  //! @brief Append all entries of another report.
+  void
+  append (const memory_report_t &other)
+  { items.insert (items.end (), other.items.begin (), other.items.end ()); };
+
+  //! bytes in use, in all entries of `category` or in total if empty.
+  std::size_t
+  used (const std::string &category = "") const {
+    std::size_t s = 0;
+    for (auto const & ii : items)
+      if (category.empty () || ii.category == category)
+	s += ii.used;
+    return s;
+  };
+
+  //! bytes allocated, in all entries of `category` or in total if empty.
+  std::size_t
+  reserved (const std::string &category = "") const {
+    std::size_t s = 0;
+    for (auto const & ii : items)
+      if (category.empty () || ii.category == category)
+	s += ii.reserved;
+    return s;
+  };
+
+  //! @brief Estimated size of a node of a `std::map<K, V>`,
+  //! tree links included, allocator overhead excluded.
+  template <typename K, typename V>
+  static constexpr std::size_t
+  map_node_bytes ()
+  { return 4 * sizeof (void *) + sizeof (std::pair<const K, V>); };
+
+  //! @brief Heap bytes held by a string, zero if stored inline.
+  static std::size_t
+  string_heap_bytes (const std::string &s) {
+    return s.capacity () > std::string ().capacity () ?
+      s.capacity () + 1 : 0;
+  };
+
+  //! @brief Estimated bytes of the nodes and keys of a map of columns
+  //! (the columns themselves are not included).
+  template <typename V, typename C, typename A>
+  static std::size_t
+  column_map_bytes (const std::map<std::string, V, C, A> &m) {
+    std::size_t s = m.size () * map_node_bytes<std::string, V> ();
+    for (auto const & ii : m)
+      s += string_heap_bytes (ii.first);
+    return s;
+  };
+
+};
+
+//! @brief Adaptor to allow implicit conversion from
+//! `memory_report_t` to `json`.
+inline void
+to_json (nlohmann::json &j, const memory_report_t &r) {
+  j = nlohmann::json::object ();
+  j["used"] = r.used ();
+  j["reserved"] = r.reserved ();
+  auto & items = j["items"] = nlohmann::json::array ();
+  for (auto const & ii : r.items)
+    items.push_back (nlohmann::json{{"category", ii.category},
+				    {"name", ii.name},
+				    {"used", ii.used},
+				    {"reserved", ii.reserved}});
+}
+
+//! @brief Print a report as a table, one line per entry
+//! followed by totals per category.
+inline std::ostream &
+operator<< (std::ostream &os, const memory_report_t &r) {
+  const auto flags = os.flags ();
+  const auto prec = os.precision ();
+  auto mib = [] (std::size_t b) { return b / (1024. * 1024.); };
+  auto line = [&] (const std::string &c, const std::string &n,
+		   std::size_t u, std::size_t s) {
+    os << std::left << std::setw (12) << c << std::setw (28) << n
+       << std::right << std::fixed << std::setprecision (3)
+       << std::setw (16) << mib (u) << std::setw (16) << mib (s) << "\n";
+  };
+  os << std::left << std::setw (12) << "category" << std::setw (28) << "name"
+     << std::right << std::setw (16) << "used (MiB)"
+     << std::setw (16) << "reserved (MiB)" << "\n";
+  std::vector<std::string> categories;
+  for (auto const & ii : r.items) {
+    line (ii.category, ii.name, ii.used, ii.reserved);
+    if (std::find (categories.begin (), categories.end (), ii.category)
+	== categories.end ())
+      categories.push_back (ii.category);
+  }
+  for (auto const & c : categories)
+    line (c, "(total)", r.used (c), r.reserved (c));
+  line ("", "(total)", r.used (), r.reserved ());
+  os.flags (flags);
+  os.precision (prec);
+  return os;
+}
+
+#endif /* MEMORY_REPORT_H */
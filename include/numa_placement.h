@@ -0,0 +1,124 @@
+#ifndef NUMA_PLACEMENT_H
+#define NUMA_PLACEMENT_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+//! @file numa_placement.h
+//! @brief First touch placement of memory and thread pinning.
+//!
+//! On Linux a page is placed on the NUMA node of the thread that
+//! first writes to it. Memory touched by the thread that allocates
+//! it ends up on a single socket and threads on the other sockets
+//! pay remote latency for every access; touching pages from a
+//! parallel loop with the same static schedule as the loops that
+//! later use the data places each range next to the thread that
+//! works on it. Without OpenMP the helpers run serially.
+
+namespace NUMA_PLACEMENT {
+
+  //! @brief Write one byte in each page of `bytes` bytes from `p`, in a
+  //! `schedule(static)` parallel loop.
+
+  //! Meant for storage that has just been allocated and holds no
+  //! objects yet; pages already placed are not moved.
+  void
+  first_touch (void *p, std::size_t bytes);
+
+  //! @brief Reserve room for `n` elements in `v`, placing new storage
+  //! by first touch.
+
+  //! If `v` needs to grow, new storage is allocated with the allocator
+  //! of `v`, touched by `first_touch` and only then filled, so that
+  //! filling it serially later does not move its pages.
+  template <class V>
+  void
+  first_touch_reserve (V &v, std::size_t n) {
+    if (v.capacity () >= n)
+      return;
+    V tmp (v.get_allocator ());
+    tmp.reserve (n);
+    first_touch (tmp.data (), tmp.capacity () * sizeof (typename V::value_type));
+    tmp.assign (v.begin (), v.end ());
+    v.swap (tmp);
+  }
+
+  //! @brief Memory resource placing large allocations by first touch.
+
+  //! Allocations of at least `min_bytes` bytes are obtained from
+  //! `upstream` and touched by `first_touch`, use it as the memory
+  //! resource of `particles_t` so that particle columns are spread
+  //! over the sockets as the particle loops are,
+  //!
+  //!     NUMA_PLACEMENT::first_touch_resource_t ft;
+  //!     particles_t ptcls (n, {}, {"m"}, grid, &ft);
+  class
+  first_touch_resource_t : public std::pmr::memory_resource {
+
+  public:
+
+    //! @param min_bytes_ smaller allocations are not touched.
+    //! @param upstream_ resource memory is obtained from.
+    explicit
+    first_touch_resource_t (std::size_t min_bytes_ = std::size_t (1) << 16,
+			    std::pmr::memory_resource *upstream_
+			    = std::pmr::get_default_resource ())
+      : min_bytes (min_bytes_), upstream (upstream_) { };
+
+  private:
+
+    void *
+    do_allocate (std::size_t bytes, std::size_t alignment) override {
+      void *p = upstream->allocate (bytes, alignment);
+      if (bytes >= min_bytes)
+	first_touch (p, bytes);
+      return p;
+    };
+
+    void
+    do_deallocate (void *p, std::size_t bytes, std::size_t alignment) override
+    { upstream->deallocate (p, bytes, alignment); };
+
+    bool
+    do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+    { return this == &other; };
+
+    std::size_t                    min_bytes;
+    std::pmr::memory_resource     *upstream;
+
+  };
+
+  //! Placement of threads on cores for `pin_threads`.
+  enum class
+  affinity_t {
+    none,       //!< leave threads where the OS puts them.
+    compact,    //!< consecutive threads on consecutive cores of a socket.
+    scatter     //!< consecutive threads on different sockets, round robin.
+  };
+
+  //! @brief Parse "none", "compact" or "scatter".
+  affinity_t
+  affinity_from_string (const std::string &name);
+
+  //! @brief Pin each OpenMP thread to one of the cores the process
+  //! may run on.
+
+  //! Cores are ordered by socket (`physical_package_id` in sysfs) and
+  //! assigned to threads following `a`; call it before allocating
+  //! and touching data, as the first touch must happen on the core
+  //! that will later use the data.
+  //! If MPI is initialized, this is collective over `MPI_COMM_WORLD`:
+  //! ranks on the same node allowed to run on the same cores take
+  //! consecutive blocks of `omp_get_max_threads ()` cores in order
+  //! of their rank on the node, ranks already bound to different
+  //! cores by the launcher use their own cores.
+  //! Returns the core of each thread, empty if `a` is `none` or
+  //! pinning is not supported.
+  std::vector<int>
+  pin_threads (affinity_t a = affinity_t::compact);
+
+}
+
+#endif /* NUMA_PLACEMENT_H */
@@ -2,23 +2,79 @@
 #define PARTICLES_H
 
 #include <algorithm>
+#include <checkpoint.h>
+#include <cmath>
+#include <density_diagnostics.h>
+#include <field_registry.h>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <json.hpp>
 #include <map>
+#include <memory_report.h>
+#include <memory_resource>
+#include <philox.h>
 #include <quadgrid_cpp.h>
+#include <sparse_field.h>
 #include <string>
 
 //! datatype for assignment operators
 using assignment_t = std::function <double& (double&, const double&)>;
 
 namespace ASSIGNMENT_OPS {
-  auto EQ = [] (double& TO, const double& FROM) -> double& { return TO = FROM; };
-  auto PLUS_EQ = [] (double& TO, const double& FROM) -> double& { return TO += FROM; };
-  auto TIMES_EQ = [] (double& TO, const double& FROM) -> double& { return TO *= FROM; };
+  inline auto EQ = [] (double& TO, const double& FROM) -> double& { return TO = FROM; };
+  inline auto PLUS_EQ = [] (double& TO, const double& FROM) -> double& { return TO += FROM; };
+  inline auto TIMES_EQ = [] (double& TO, const double& FROM) -> double& { return TO *= FROM; };
 }
 
+//! @brief Positions and property columns of `particles_t`, and the
+//! memory resource they are allocated from.
+
+//! Kept apart from the rest of the state of particles, which copies
+//! take as it is, because copies of the columns need a resource:
+//! as for any copy of a `std::pmr` container, they are allocated
+//! from the default resource rather than from the resource of the
+//! original (e.g. a memory mapped file), and `resource` is set
+//! accordingly. Moves take over columns and `resource`.
+struct
+particle_columns_t {
+
+  //! datatype of `double` columns (positions and `dprops`).
+  using dcolumn_t = std::pmr::vector<double>;
+
+  //! datatype of integer columns (`iprops`).
+  using icolumn_t = std::pmr::vector<quadgrid_t<std::vector<double>>::idx_t>;
+
+  //! memory resource positions and property columns are allocated
+  //! from, e.g. a `mapped_resource_t` to keep them in files.
+  std::pmr::memory_resource *resource;
+
+  dcolumn_t x;            //!< x coordinate of particle positions.
+  dcolumn_t y;            //!< y coordinate of particle positions.
+
+  //! integer type quantities associated with the particles.
+  std::pmr::map<std::string, icolumn_t> iprops;
+  
+  //! `double` type quantities associated with the particles.
+  std::pmr::map<std::string, dcolumn_t> dprops;  
+
+  //! @brief Empty columns allocated from `mr`, the default resource
+  //! if `nullptr`.
+  explicit
+  particle_columns_t (std::pmr::memory_resource *mr)
+    : resource (mr ? mr : std::pmr::get_default_resource ()),
+      x (resource), y (resource), iprops (resource), dprops (resource) { }
+
+  //! @brief Copy the columns to the default resource.
+  particle_columns_t (const particle_columns_t &other);
+
+  particle_columns_t (particle_columns_t &&other) = default;
+
+  //! Delete assignment operators, columns would keep their resource.
+  particle_columns_t &
+  operator= (const particle_columns_t &) = delete;
+};
+
 //! \brief Class to represent particles embedded in a grid.
 
 //! Offers methods for transfer of quantities from particles
@@ -34,25 +90,50 @@ namespace ASSIGNMENT_OPS {
 //! the method `init_particle_mesh ()`
 
 struct
-particles_t {
+particles_t : particle_columns_t {
 
   //! datatype for indexing into vectors of properties
   using idx_t = quadgrid_t<std::vector<double>>::idx_t;
-  
+
+  //! datatype of particle indices in `grd_to_ptcl`, may be narrower
+  //! than `idx_t` (see quadgrid_config.h).
+  using bin_idx_t = QUADGRID_CONFIG::bin_idx_t;
+
   idx_t num_particles;    //!< number of particles.
-  std::vector<double> x;  //!< x coordinate of particle positions.
-  std::vector<double> y;  //!< y coordinate of particle positions.
 
-  //! integer type quantities associated with the particles.
-  std::map<std::string, std::vector<idx_t>> iprops;
-  
-  //! `double` type quantities associated with the particles.
-  std::map<std::string, std::vector<double>> dprops;  
+  std::map<idx_t, std::vector<bin_idx_t>> grd_to_ptcl;  //!< grid/particles connectivity.
 
-  std::vector<double> M; //!< Mass matrix to be used for transfers if required.
-  std::map<idx_t, std::vector<idx_t>> grd_to_ptcl;   //!< grid/particles connectivity.
+  //! @brief Sorted global indices of the cells containing at least
+  //! one particle, transfers only visit these cells. Particles outside
+  //! the grid are kept in `grd_to_ptcl`, under `quadgrid_t::out_of_grid`,
+  //! but are not listed.
+  std::vector<idx_t> active_cells;
   const quadgrid_t<std::vector<double>>& grid;       //!< refernce to a grid object.
 
+  //! timers and counters for transfers, binning and export,
+  //! updated only if compiled with `QUADGRID_INSTRUMENT` defined.
+  mutable instrumentation_t stats;
+
+  //! number of calls to `default_x_generator` and
+  //! `default_y_generator`, respectively.
+  std::uint64_t x_draws = 0, y_draws = 0;
+
+  //! incremented each time particles are binned again,
+  //! by `init_particle_mesh` or `seed_cells`.
+  std::uint64_t binning_version = 0;
+
+  //! property `M` was assembled from by `build_particle_mass`,
+  //! empty if `M` is not particle-weighted.
+  std::string mass_prop;
+
+  //! `binning_version` when `M` was assembled from particles.
+  std::uint64_t mass_version = 0;
+
+  //! hash of the positions and masses `M` was assembled from,
+  //! so that moving particles or changing their masses is noticed
+  //! even if they are not binned again.
+  std::uint64_t mass_hash = 0;
+
   //! Enumeration of available output format
   enum class
   output_format : idx_t {
@@ -67,19 +148,31 @@ particles_t {
                        //! via the ctor, useful for restart data
   };
 
-  //! @brief The default generator function used to set up
-  //! x-coordinates of particle positions if none is
-  //! is specified.
+  //! Placement of particles within cells for `seed_cells`.
+  enum class
+  seeding_t {
+    lattice,           //!< centers of a regular lattice of sub-cells.
+    jittered           //!< one random point in each sub-cell.
+  };
 
-  //! Generates a uniform random distribution.
+  //! seed of the positions drawn by the ctor with default generators.
+  static constexpr std::uint64_t default_seed = 5489u;
+
+  //! @brief Generator of x-coordinates of particle positions
+  //! drawn one at a time.
+
+  //! Generates a uniform random distribution, the n-th call on
+  //! an object returns the x-coordinate of particle n as set by
+  //! `init_particle_positions (default_seed)`.
   double
   default_x_generator ();
 
-  //! @brief The default generator function used to set up
-  //! y-coordinates of particle positions if none is
-  //! is specified.
+  //! @brief Generator of y-coordinates of particle positions
+  //! drawn one at a time.
 
-  //! Generates a uniform random distribution.
+  //! Generates a uniform random distribution, the n-th call on
+  //! an object returns the y-coordinate of particle n as set by
+  //! `init_particle_positions (default_seed)`.
   double
   default_y_generator ();
 
@@ -98,35 +191,79 @@ particles_t {
   //! Particle positions are not assigned, they must be set manually later.
   //! @param n number of particles
   //! @param grid_ quadgrid_t object, sizes need to have been already set up.
-  particles_t (idx_t n, const quadgrid_t<std::vector<double>>& grid_)
-    : num_particles(n), grid(grid_) { } 
+  //! @param mr memory resource for the columns, the default resource if `nullptr`.
+  particles_t (idx_t n, const quadgrid_t<std::vector<double>>& grid_,
+	       std::pmr::memory_resource *mr = nullptr)
+    : particle_columns_t (mr), num_particles(n), grid(grid_) { } 
+
+  //! @brief Copy constructor, columns are copied to the default
+  //! resource (see `particle_columns_t`).
+  particles_t (const particles_t &other) = default;
+
+  //! @brief Move constructor, columns and `resource` are taken over.
+  particles_t (particles_t &&other) = default;
 
   //! @brief Ctor to import data from json.
   
   //! Grid data may be stored in the same `json` object but must be read
   //! separately before invoking this constructor.
   particles_t (const nlohmann::json &j,
-	       const quadgrid_t<std::vector<double>>& grid_)
-    :  grid(grid_)
+	       const quadgrid_t<std::vector<double>>& grid_,
+	       std::pmr::memory_resource *mr = nullptr)
+    :  particles_t (0, grid_, mr)
   {
-    j["dprops"].get_to<std::map<std::string, std::vector<double>>> (dprops);
-    j["iprops"].get_to<std::map<std::string, std::vector<int>>> (iprops);
-    j["x"].get_to<std::vector<double>> (x);
-    j["y"].get_to<std::vector<double>> (y);
+    j["dprops"].get_to (dprops);
+    j["iprops"].get_to (iprops);
+    j["x"].get_to (x);
+    j["y"].get_to (y);
     j["num_particles"].get_to<idx_t> (num_particles);
   }
+
+  //! @brief Ctor to import data from a binary checkpoint.
+
+  //! Each column is copied from the memory mapped file with a
+  //! single `memcpy`, the grid/particles connectivity is rebuilt.
+  //! As for the json ctor, the grid must be set up beforehand,
+  //! e.g. via `checkpoint_t::set_grid`. Throws `std::runtime_error`
+  //! if a particle column does not have one entry per particle.
+  particles_t (const checkpoint_t &ckpt,
+	       const quadgrid_t<std::vector<double>>& grid_,
+	       std::pmr::memory_resource *mr = nullptr);
+
+  //! @brief Ctor to stream data from a json text.
+
+  //! Parses the json text with the SAX interface of `nlohmann::json`
+  //! directly into the `x`, `y`, `dprops` and `iprops` columns
+  //! without building a json object in memory, particles are added
+  //! to `grd_to_ptcl` as soon as both their coordinates are read.
+  //! Columns are reserved as soon as the number of particles is known
+  //! (from `num_particles_hint`, from the `num_particles` field or
+  //! from the length of the first column), so peak memory stays
+  //! close to the size of the data.
+  //! As for the json ctor, the grid must be set up beforehand, if the
+  //! input contains `grid_properties` they must match those of `grid_`.
+  //! @param is stream to read the json text from.
+  //! @param grid_ quadgrid_t object, sizes need to have been already set up.
+  //! @param grid_vars if not `nullptr`, fields in `grid_vars` are stored here.
+  //! @param num_particles_hint expected number of particles, 0 if unknown.
+  particles_t (std::istream &is,
+	       const quadgrid_t<std::vector<double>>& grid_,
+	       std::map<std::string, std::vector<double>> *grid_vars = nullptr,
+	       idx_t num_particles_hint = 0,
+	       std::pmr::memory_resource *mr = nullptr);
   
   //! @brief Constructor with default position generators.
   
   //! Distributes particles randomly over the
-  //! grid.
+  //! grid, via `init_particle_positions (default_seed)`.
   //! @param n number of particles
   //! @param grid_ quadgrid_t object, sizes need to have been already set up.
   //! @param ipropnames keys for entries in the particles_t::iprops map.
   //! @param dpropnames keys for entries in the particles_t::dprops map.
   particles_t (idx_t n, const std::vector<std::string>& ipropnames,
 	       const std::vector<std::string>& dpropnames,
-	       const quadgrid_t<std::vector<double>>& grid_);
+	       const quadgrid_t<std::vector<double>>& grid_,
+	       std::pmr::memory_resource *mr = nullptr);
 
   //! @brief Constructor with custom position vectors.
   
@@ -143,7 +280,8 @@ particles_t {
 	       const std::vector<std::string>& dpropnames,
 	       const quadgrid_t<std::vector<double>>& grid_,
 	       const std::vector<double> & xv,
-	       const std::vector<double> & yv);
+	       const std::vector<double> & yv,
+	       std::pmr::memory_resource *mr = nullptr);
 
   //! @brief Constructor with custom position generators.
   
@@ -160,7 +298,8 @@ particles_t {
 	       const std::vector<std::string>& dpropnames,
 	       const quadgrid_t<std::vector<double>>& grid_,
 	       std::function<double ()> xgen,
-	       std::function<double ()> ygen);
+	       std::function<double ()> ygen,
+	       std::pmr::memory_resource *mr = nullptr);
 
   //! @brief Initialize particle properties.
   
@@ -173,6 +312,19 @@ particles_t {
   init_props (const std::vector<std::string>& ipropnames,
 	      const std::vector<std::string>& dpropnames);
 
+  //! @brief Reserve room for `n` particles in all columns.
+
+  //! Capacities are rounded up to a multiple of `column_padding`
+  //! bytes, so loops over a column can run in full SIMD vectors.
+  //! Columns that need to grow are reallocated together, all new
+  //! columns being allocated before the old ones are freed, so
+  //! with an `arena_resource_t` they end up adjacent in memory.
+  void
+  reserve (idx_t n);
+
+  //! capacities set by `reserve` are multiples of this many bytes.
+  static constexpr std::size_t column_padding = 64;
+
   //! @brief Erase particcles based on coordinates.
 
   //! Given a function to decide whether a particle
@@ -181,6 +333,8 @@ particles_t {
   //! erase corresponding entries in dprops and iprops.
   void
   remove_in_region (std::function<bool (double, double)> fun) {
+    QUADGRID_PHASE (stats, phase_t::remove_in_region);
+    QUADGRID_COUNT (particles, num_particles);
     std::vector<idx_t> vin{};
     for (idx_t i = 0; i < num_particles; ++i) {
       if (fun (x[i], y[i])) {
@@ -209,11 +363,52 @@ particles_t {
 
   //! @brief Build grid/particles connectivity.
   
-  //! Builds/updates the `grd_to_ptcl` map. Must be used whenever
-  //! particles cross cell boundaries.
+  //! Builds/updates the `grd_to_ptcl` map and the list of
+  //! `active_cells`. Must be used whenever particles cross cell
+  //! boundaries.
   void
   init_particle_mesh ();
 
+  //! @brief Rebuild `active_cells`, and the list of their nodes,
+  //! from `grd_to_ptcl`.
+
+  //! Invoked by `init_particle_mesh ()`, must be invoked manually
+  //! only if `grd_to_ptcl` is modified directly.
+  void
+  update_active_cells ();
+
+  //! @brief Global index of the cell containing point (`xx`, `yy`),
+  //! `quadgrid_t::out_of_grid` for points outside the grid.
+  idx_t
+  cell_index (double xx, double yy) const {
+    idx_t c = static_cast<idx_t> (std::floor (xx / grid.hx ()));
+    idx_t r = static_cast<idx_t> (std::floor (yy / grid.hy ()));
+    return grid.sub2gind (r, c);
+  }
+
+  //! @brief Memory held by the particles.
+
+  //! Reports bytes used and reserved by positions, each property
+  //! column, the keys of the property maps, the binning index
+  //! (`grd_to_ptcl` tree nodes and per-cell vectors) and the mass
+  //! vector. Grid fields are not owned by particles, use
+  //! `quadgrid_t::memory_report` to account for them.
+  memory_report_t
+  memory_report () const;
+
+  //! @brief Particle density and load imbalance statistics.
+
+  //! Counts particles per cell from the `grd_to_ptcl` connectivity,
+  //! cost is proportional to the number of occupied cells (plus
+  //! allocation of the per-cell counts).
+  //! @param num_parts number of workers for the imbalance estimate,
+  //! if 0 the number of OpenMP threads (or 1 without OpenMP).
+  //! @param collective if true also compute the imbalance of particle
+  //! numbers among the ranks of the grid communicator, in that case
+  //! must be invoked by all ranks.
+  density_diagnostics_t
+  density_diagnostics (idx_t num_parts = 0, bool collective = false) const;
+
   //! @brief Initialize particle positions with generator functions.
   
   //! Invoked automatically if the generators are passed to the CTOR,
@@ -222,13 +417,97 @@ particles_t {
   init_particle_positions (std::function<double ()> xgentr,
 			   std::function<double ()> ygentr);
 
+  //! @brief Initialize particle positions uniformly at random
+  //! with a counter-based generator.
+
+  //! The position of particle `ii` only depends on `seed` and on
+  //! `first_index + ii`, positions are filled in parallel with
+  //! OpenMP and do not depend on the number of threads; if each rank
+  //! passes the global index of its first particle as `first_index`
+  //! they do not depend on the number of ranks either.
+  void
+  init_particle_positions (std::uint64_t seed,
+			   std::uint64_t first_index = 0);
+
+  //! @brief Place particles cell by cell, already binned.
+
+  //! Each cell is split in `nx` x `ny` sub-cells and a particle is
+  //! placed in each sub-cell, at its center (`seeding_t::lattice`)
+  //! or at a random point (`seeding_t::jittered`, drawn from `seed`,
+  //! the cell index and the sub-cell index, so positions do not
+  //! depend on the order of generation); particles for which
+  //! `inside (x, y)` is false are skipped.
+  //! Particles are stored grouped by cell, in cell index order, and
+  //! `grd_to_ptcl` and `active_cells` are filled while they are
+  //! generated, so no call to `init_particle_mesh` is needed.
+  //! Existing particles are replaced, property columns are resized
+  //! to the new number of particles and set to zero.
+  //! Throws `std::invalid_argument` if `nx` or `ny` is not positive.
+  void
+  seed_cells (idx_t nx, idx_t ny,
+	      seeding_t mode = seeding_t::lattice,
+	      std::function<bool (double, double)> inside = nullptr,
+	      std::uint64_t seed = default_seed);
+
   //! @brief Construct a mass matrix.
 
   //! Must be invoked manually before invoking any of the transfer
-  //! methods with flag `use_mass` set to `true`
+  //! methods with flag `use_mass` set to `true`.
+  //! `M` is copied from the lumped mass of the grid, which is
+  //! computed in closed form once per grid (see
+  //! `quadgrid_t::lumped_mass`).
   void
   build_mass ();
 
+  //! @brief Construct a particle-weighted lumped mass matrix.
+
+  //! Sets `M` to the sum over particles of the shape functions
+  //! weighted by property `mass`, as for `p2g` of `mass`, and
+  //! `Minv` to its inverse, zero at nodes without particles.
+  //! Columns of cells of the same parity share no nodes, so they
+  //! are assembled in parallel, one parity after the other; the
+  //! result does not depend on the number of threads.
+  //! The matrix is kept, and a call does nothing, as long as the
+  //! particles are not binned again (see `binning_version`) and
+  //! neither their positions nor the values of `mass` change, which
+  //! is checked by hashing them.
+  void
+  build_particle_mass (const std::string & mass = "m");
+
+  //! @brief Set the mass matrix to `m`, one value per grid node,
+  //! e.g. a mass not computed by `build_mass`.
+
+  //! Throws `std::invalid_argument` if the size of `m` does not
+  //! match the grid.
+  void
+  set_mass (std::vector<double> m);
+
+  //! @brief Mass matrix used by transfers with `apply_mass` set.
+
+  //! Read-only, so that it cannot get out of step with its inverse:
+  //! use `build_mass`, `build_particle_mass` or `set_mass` to
+  //! change it.
+  const std::vector<double> &
+  mass () const
+  { return M; };
+
+  //! @brief Inverse of the mass matrix, zero at nodes with zero mass.
+
+  //! Transfers with `apply_mass` set multiply by it rather than
+  //! dividing by the mass.
+  const std::vector<double> &
+  inverse_mass () const
+  { return Minv; };
+
+  //! @brief Multiply the fields in `gvars` by `Minv`, in a single
+  //! sweep for all fields over the nodes of `active_cells`, the
+  //! only ones particles transfer to; other nodes are left as they
+  //! are.
+  //! @param components values per node of each field, all 1 if empty.
+  void
+  apply_inverse_mass (std::vector<double *> const & gvars,
+		      std::vector<int> const & components = {}) const;
+
   //! @brief shortcut for `dprops.at (name) [ii]`
   double &
   dp (const std::string & name, idx_t ii) {
@@ -274,6 +553,13 @@ particles_t {
     return *(std::next (varnames.begin (), ivar));
   };
 
+  static
+  const std::string &
+  getkey(std::map<std::string, sparse_field_t> const &varnames,
+	 std::size_t ivar)  {
+    return std::next (varnames.begin (), ivar)->first;
+  };
+
   //! @brief Map particle variables to the grid.
 
   //! Assume all fields of `vars` are to be mapped,
@@ -307,6 +593,52 @@ particles_t {
        bool apply_mass = false,
        assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ) const;
   
+  //! @brief Map particle variables to sparse grid fields.
+
+  //! Same as the dense version, tiles of the fields are allocated
+  //! only where particles are. Fields listed in `gvarnames` must
+  //! already be in `vars`, constructed on the grid of the particles.
+  void
+  p2g (std::map<std::string, sparse_field_t> & vars,
+       bool apply_mass = false) const {
+    p2g (vars, vars, vars, apply_mass);
+  }
+
+  template<typename GT, typename PT>
+  void
+  p2g (std::map<std::string, sparse_field_t> & vars,
+       PT const & pvarnames,
+       GT const & gvarnames,
+       bool apply_mass = false,
+       assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ) const;
+
+  template<typename str>
+  void
+  p2g (std::map<std::string, sparse_field_t> & vars,
+       std::initializer_list<str> const & pvarnames,
+       std::initializer_list<str> const & gvarnames,
+       bool apply_mass = false,
+       assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ) const;
+
+  //! @brief Map particle variables to fields of a registry.
+
+  //! Fields are given by handle, particle variables by name; fields
+  //! with a zeroing pending (see `field_registry_t::zero`) are
+  //! cleared in the same pass. A field with `k` components takes
+  //! the next `k` names of `pvarnames`, e.g.
+  //!
+  //!     ptcls.p2g (fields, {"m", "mvx", "mvy"}, {hm, hmv});
+  //!
+  //! with `hmv` a field of 2 components, all components of a node
+  //! are updated at once. Throws `std::invalid_argument` unless
+  //! there are as many names as components in all.
+  void
+  p2g (field_registry_t & fields,
+       std::vector<std::string> const & pvarnames,
+       std::vector<field_registry_t::handle_t> const & gvars,
+       bool apply_mass = false,
+       assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ) const;
+
   template<typename GT, typename PT>
   void
   p2gd (std::map<std::string, std::vector<double>> & vars,
@@ -349,6 +681,40 @@ particles_t {
        bool apply_mass = false,
        assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ);
 
+  //! @brief Map sparse grid fields to particle variables,
+  //! nodes of unallocated tiles count as zero.
+  void
+  g2p (const std::map<std::string, sparse_field_t>& vars,
+       bool apply_mass = false, assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ) {
+    g2p (vars, vars, vars, apply_mass, OP);
+  }
+
+  template<typename str>
+  void
+  g2p (const std::map<std::string, sparse_field_t>& vars,
+       std::initializer_list<str> const & gvarnames,
+       std::initializer_list<str> const & pvarnames,
+       bool apply_mass = false,
+       assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ);
+
+  template<typename GT, typename PT>
+  void
+  g2p (const std::map<std::string, sparse_field_t>& vars,
+       GT const & gvarnames,
+       PT const & pvarnames,
+       bool apply_mass = false,
+       assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ);
+
+  //! @brief Map fields of a registry to particle variables, a
+  //! field with `k` components fills the next `k` names of
+  //! `pvarnames`, as for `p2g`.
+  void
+  g2p (const field_registry_t & fields,
+       std::vector<field_registry_t::handle_t> const & gvars,
+       std::vector<std::string> const & pvarnames,
+       bool apply_mass = false,
+       assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ);
+
   template<typename GT, typename PT>
   void
   g2pd (const std::map<std::string, std::vector<double>>& vars,
@@ -367,6 +733,18 @@ particles_t {
 	bool apply_mass = false,
 	assignment_t OP = ASSIGNMENT_OPS::PLUS_EQ);
 
+private:
+
+  //! set `Minv` to the inverse of `M`, whenever `M` changes.
+  void
+  update_inverse_mass ();
+
+  std::vector<double> M;      //!< mass matrix to be used for transfers if required.
+  std::vector<double> Minv;   //!< inverse of `M`.
+
+  //! nodes of `active_cells`, sorted, for `apply_inverse_mass`.
+  std::vector<idx_t> active_nodes;
+
 };
 
 //! @brief Adaptor to allow implicit conversion from
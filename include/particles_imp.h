@@ -23,35 +23,38 @@ particles_t::p2g
   double N = 0.0, xx = 0.0, yy = 0.0;
   idx_t idx = 0;
 
+  QUADGRID_PHASE (stats, phase_t::p2g);
+  QUADGRID_COUNT (particles, x.size () * std::size (gvarnames));
+  QUADGRID_COUNT (cells, active_cells.size () * std::size (gvarnames));
+
   for (std::size_t ivar = 0; ivar < std::size(gvarnames); ++ivar) {
-    auto & gvar = vars[getkey(gvarnames, ivar)];
+    QUADGRID_SPAN ("p2g_field", "transfer");
+    auto & gvar = vars.at (getkey(gvarnames, ivar));
     auto const & dprop = dprops.at (getkey(pvarnames, ivar));
-    for (auto icell = grid.begin_cell_sweep ();
-	 icell != grid.end_cell_sweep (); ++icell) {
-
-      if (grd_to_ptcl.count (icell->get_global_cell_idx ()) > 0)
-	for (idx_t ii = 0;
-	     ii < grd_to_ptcl.at (icell->get_global_cell_idx ()).size ();
-	     ++ii) {
-	  idx = grd_to_ptcl.at (icell->get_global_cell_idx ())[ii];
-	  xx = x[idx];
-	  yy = y[idx];
-
-	  for (idx_t inode = 0; inode < 4; ++inode) {
-	    N = icell->shp(xx, yy, inode);
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const & plist = grd_to_ptcl.at (gidx);
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+	idx = plist[ii];
+	xx = x[idx];
+	yy = y[idx];
+
+	for (idx_t inode = 0; inode < 4; ++inode) {
+	  N = icell.shp(xx, yy, inode);
 	  
-	    OP (gvar[icell->gt(inode)], 
-		N * dprop[idx]);
-	  }
+	  OP (gvar[icell.gt(inode)], 
+	      N * dprop[idx]);
 	}
+      }
     }
   }
 
-  if (apply_mass)
+  if (apply_mass) {
+    std::vector<double *> gvars;
     for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar)
-      for (idx_t ii = 0; ii < M.size (); ++ii) {
-	vars[getkey(gvarnames, ivar)][ii]  /= M[ii];
-      }
+      gvars.push_back (vars.at (getkey (gvarnames, ivar)).data ());
+    apply_inverse_mass (gvars);
+  }
 }
 
 
@@ -84,42 +87,45 @@ particles_t::p2gd
   double xx = 0.0, yy = 0.0, Nx = 0.0, Ny = 0.0;
   idx_t idx = 0;
 
+  QUADGRID_PHASE (stats, phase_t::p2gd);
+  QUADGRID_COUNT (particles, x.size () * std::size (gvarnames));
+  QUADGRID_COUNT (cells, active_cells.size () * std::size (gvarnames));
+
   for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar) {
-    auto & gvar = vars[getkey(gvarnames, ivar)];
+    QUADGRID_SPAN ("p2gd_field", "transfer");
+    auto & gvar = vars.at (getkey(gvarnames, ivar));
     auto const & dpropx = dprops.at (getkey(pxvarnames, ivar));
     auto const & dpropy = dprops.at (getkey(pyvarnames, ivar));
     auto const & dproparea = dprops.at (area);
-    for (auto icell = grid.begin_cell_sweep();
-	 icell != grid.end_cell_sweep(); ++icell) {
-
-      if (grd_to_ptcl.count (icell->get_global_cell_idx ()) > 0)
-	for (idx_t ii = 0;
-	     ii < grd_to_ptcl.at (icell->get_global_cell_idx ()).size ();
-	     ++ii) {
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const & plist = grd_to_ptcl.at (gidx);
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
 
-	  idx = grd_to_ptcl.at (icell->get_global_cell_idx())[ii];
-	  xx = x[idx];
-	  yy = y[idx];
+	idx = plist[ii];
+	xx = x[idx];
+	yy = y[idx];
 
-	  for (idx_t inode=0; inode<4; ++inode) {
+	for (idx_t inode=0; inode<4; ++inode) {
 
-	    Nx = icell->shg (xx, yy, 0, inode);
-	    Ny = icell->shg (xx, yy, 1, inode);
+	  Nx = icell.shg (xx, yy, 0, inode);
+	  Ny = icell.shg (xx, yy, 1, inode);
 
 	  
-	    OP (gvar[icell->gt(inode)],
-		(Nx * dpropx[idx] + Ny * dpropy[idx]) * dproparea[idx]);
-	  }
+	  OP (gvar[icell.gt(inode)],
+	      (Nx * dpropx[idx] + Ny * dpropy[idx]) * dproparea[idx]);
 	}
+      }
     }
 
   }
 
-  if (apply_mass)
+  if (apply_mass) {
+    std::vector<double *> gvars;
     for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar)
-      for (idx_t ii = 0; ii < M.size (); ++ii) {
-	vars[getkey(gvarnames, ivar)][ii]  /= M[ii];
-      }
+      gvars.push_back (vars.at (getkey (gvarnames, ivar)).data ());
+    apply_inverse_mass (gvars);
+  }
 
 }
 
@@ -144,32 +150,37 @@ particles_t::g2p
  bool apply_mass, assignment_t OP) {
 
   using idx_t = quadgrid_t<std::vector<double>>::idx_t;
-  double N = 0.0, xx = 0.0, yy = 0.0;
+  double xx = 0.0, yy = 0.0, w[4];
   idx_t idx = 0;
 
+  QUADGRID_PHASE (stats, phase_t::g2p);
+  QUADGRID_COUNT (particles, x.size () * std::size (gvarnames));
+  QUADGRID_COUNT (cells, active_cells.size () * std::size (gvarnames));
+
   for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar) {
+    QUADGRID_SPAN ("g2p_field", "transfer");
     auto & dprop = dprops.at (getkey (pvarnames, ivar));
     auto const & gvar = vars.at (getkey (gvarnames, ivar));
-    for (auto icell = grid.begin_cell_sweep ();
-	 icell != grid.end_cell_sweep (); ++icell) {
-
-      if (grd_to_ptcl.count (icell->get_global_cell_idx ()) > 0)
-	for (idx_t ii = 0;
-	     ii < grd_to_ptcl.at (icell->get_global_cell_idx ()).size ();
-	     ++ii) {
-
-	  idx = grd_to_ptcl.at(icell->get_global_cell_idx ())[ii];
-	  xx = x[idx];
-	  yy = y[idx];
-
-	  for (idx_t inode = 0; inode < 4; ++inode) {
-	    N = apply_mass ?
-	      icell->shp(xx, yy, inode) * M[icell->gt(inode)] :
-	      icell->shp(xx, yy, inode);
-	  
-	    OP (dprop [idx], N * gvar[icell->gt(inode)]);
-	  }
-	}
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const & plist = grd_to_ptcl.at (gidx);
+
+      // nodal values, weighted by the mass, are the same
+      // for all particles in the cell
+      for (idx_t inode = 0; inode < 4; ++inode)
+	w[inode] = apply_mass ?
+	  M[icell.gt (inode)] * gvar[icell.gt (inode)] :
+	  gvar[icell.gt (inode)];
+
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+
+	idx = plist[ii];
+	xx = x[idx];
+	yy = y[idx];
+
+	for (idx_t inode = 0; inode < 4; ++inode)
+	  OP (dprop [idx], icell.shp (xx, yy, inode) * w[inode]);
+      }
     }
   }
 }
@@ -197,41 +208,161 @@ particles_t::g2pd
  bool apply_mass, assignment_t OP) {
 
   using idx_t = quadgrid_t<std::vector<double>>::idx_t;
-  double Nx = 0.0, Ny = 0.0, xx = 0.0, yy = 0.0;
+  double xx = 0.0, yy = 0.0, w[4];
   idx_t idx = 0;
 
+  QUADGRID_PHASE (stats, phase_t::g2pd);
+  QUADGRID_COUNT (particles, x.size () * std::size (gvarnames));
+  QUADGRID_COUNT (cells, active_cells.size () * std::size (gvarnames));
+
   for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar) {
+    QUADGRID_SPAN ("g2pd_field", "transfer");
     
-    for (auto icell = grid.begin_cell_sweep ();
-	 icell != grid.end_cell_sweep (); ++icell) {
-      auto & dpropx = dprops.at (getkey (pxvarnames, ivar));
-      auto & dpropy = dprops.at (getkey (pyvarnames, ivar));
-      auto const & gvar = vars.at (getkey (gvarnames, ivar));
-      if (grd_to_ptcl.count (icell->get_global_cell_idx ()) > 0)
-	for (idx_t ii = 0;
-	     ii < grd_to_ptcl.at (icell->get_global_cell_idx ()).size ();
-	     ++ii) {
-
-	  idx = grd_to_ptcl.at(icell->get_global_cell_idx ())[ii];
-	  xx = x[idx];
-	  yy = y[idx];
-
-	  for (idx_t inode = 0; inode < 4; ++inode) {
-	    Nx = apply_mass ?
-	      icell->shg(xx, yy, 0, inode) * M[icell->gt(inode)] :
-	      icell->shg(xx, yy, 0, inode);
-	    Ny = apply_mass ?
-	      icell->shg(xx, yy, 1, inode) * M[icell->gt(inode)] :
-	      icell->shg(xx, yy, 1, inode);
-
-	    OP (dpropx[idx], Nx * gvar[icell->gt(inode)]);
-	    OP (dpropy[idx], Ny * gvar[icell->gt(inode)]);
-	  }
+    auto & dpropx = dprops.at (getkey (pxvarnames, ivar));
+    auto & dpropy = dprops.at (getkey (pyvarnames, ivar));
+    auto const & gvar = vars.at (getkey (gvarnames, ivar));
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const & plist = grd_to_ptcl.at (gidx);
+
+      for (idx_t inode = 0; inode < 4; ++inode)
+	w[inode] = apply_mass ?
+	  M[icell.gt (inode)] * gvar[icell.gt (inode)] :
+	  gvar[icell.gt (inode)];
+
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+
+	idx = plist[ii];
+	xx = x[idx];
+	yy = y[idx];
+
+	for (idx_t inode = 0; inode < 4; ++inode) {
+	  OP (dpropx[idx], icell.shg (xx, yy, 0, inode) * w[inode]);
+	  OP (dpropy[idx], icell.shg (xx, yy, 1, inode) * w[inode]);
+	}
+      }
+    }
+
+  }
+
+}
+
+template<typename str>
+void
+particles_t::p2g
+(std::map<std::string, sparse_field_t> & vars,
+ std::initializer_list<str> const & pvarnames,
+ std::initializer_list<str> const & gvarnames,
+ bool apply_mass, assignment_t OP) const {
+  using strlist = std::initializer_list<str> const &;
+  p2g<strlist, strlist>
+    (vars, pvarnames, gvarnames, apply_mass, OP);
+}
+
+template<typename GT, typename PT>
+void
+particles_t::p2g
+(std::map<std::string, sparse_field_t> & vars,
+ PT const & pvarnames,
+ GT const & gvarnames,
+ bool apply_mass,
+ assignment_t OP) const {
+
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+  double N = 0.0, xx = 0.0, yy = 0.0;
+  idx_t idx = 0;
+
+  QUADGRID_PHASE (stats, phase_t::p2g);
+  QUADGRID_COUNT (particles, x.size () * std::size (gvarnames));
+  QUADGRID_COUNT (cells, active_cells.size () * std::size (gvarnames));
+
+  for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar) {
+    QUADGRID_SPAN ("p2g_field", "transfer");
+    auto & gvar = vars.at (getkey (gvarnames, ivar));
+    auto const & dprop = dprops.at (getkey (pvarnames, ivar));
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const r = icell.row_idx ();
+      auto const c = icell.col_idx ();
+      auto const & plist = grd_to_ptcl.at (gidx);
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+	idx = plist[ii];
+	xx = x[idx];
+	yy = y[idx];
+
+	// node inode is (r + inode % 2, c + inode / 2), see cell_t::gt
+	for (idx_t inode = 0; inode < 4; ++inode) {
+	  N = icell.shp (xx, yy, inode);
+	  OP (gvar.touch (r + inode % 2, c + inode / 2), N * dprop[idx]);
 	}
+      }
     }
+  }
 
+  if (apply_mass && ! M.empty ()) {
+    QUADGRID_SPAN ("apply_mass", "transfer");
+    auto const & Mi = inverse_mass ();
+    for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar)
+      vars.at (getkey (gvarnames, ivar)).for_each
+	([&Mi] (idx_t inode, double &v) { v *= Mi[inode]; });
   }
+}
+
+template<typename str>
+void
+particles_t::g2p
+(const std::map<std::string, sparse_field_t> & vars,
+ std::initializer_list<str> const & gvarnames,
+ std::initializer_list<str> const & pvarnames,
+ bool apply_mass, assignment_t OP) {
+  using strlist = std::initializer_list<str> const &;
+  g2p<strlist, strlist> (vars, gvarnames,
+			 pvarnames, apply_mass, OP);
+}
+
+template<typename GT, typename PT>
+void
+particles_t::g2p
+(const std::map<std::string, sparse_field_t>& vars,
+ GT const & gvarnames,
+ PT const & pvarnames,
+ bool apply_mass, assignment_t OP) {
 
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+  double xx = 0.0, yy = 0.0, w[4];
+  idx_t idx = 0;
+
+  QUADGRID_PHASE (stats, phase_t::g2p);
+  QUADGRID_COUNT (particles, x.size () * std::size (gvarnames));
+  QUADGRID_COUNT (cells, active_cells.size () * std::size (gvarnames));
+
+  for (std::size_t ivar = 0; ivar < std::size (gvarnames); ++ivar) {
+    QUADGRID_SPAN ("g2p_field", "transfer");
+    auto & dprop = dprops.at (getkey (pvarnames, ivar));
+    auto const & gvar = vars.at (getkey (gvarnames, ivar));
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const r = icell.row_idx ();
+      auto const c = icell.col_idx ();
+      auto const & plist = grd_to_ptcl.at (gidx);
+
+      // one tile lookup per node and cell rather than per particle
+      for (idx_t inode = 0; inode < 4; ++inode) {
+	w[inode] = gvar.at (r + inode % 2, c + inode / 2);
+	if (apply_mass)
+	  w[inode] *= M[icell.gt (inode)];
+      }
+
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+	idx = plist[ii];
+	xx = x[idx];
+	yy = y[idx];
+
+	for (idx_t inode = 0; inode < 4; ++inode)
+	  OP (dprop [idx], icell.shp (xx, yy, inode) * w[inode]);
+      }
+    }
+  }
 }
 
 template<>
@@ -0,0 +1,77 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+//! @brief Counter-based random number generator (Philox4x32-10).
+
+//! Each output block is a pure function of a 64 bit key (the seed)
+//! and a 128 bit counter, here made of an index (e.g. the global
+//! index of a particle) and a stream id (e.g. to draw positions and
+//! velocities independently), so numbers can be generated in any
+//! order, by any number of threads or ranks, and the results do not
+//! depend on how the work is split.
+//! See Salmon et al., "Parallel random numbers: as easy as 1, 2, 3",
+//! SC'11.
+class
+philox_t {
+
+public:
+
+  using result_t = std::array<std::uint32_t, 4>;
+
+  explicit
+  philox_t (std::uint64_t seed)
+    : key {static_cast<std::uint32_t> (seed),
+	   static_cast<std::uint32_t> (seed >> 32)} { };
+
+  //! @brief Four 32 bit random words for counter (`index`, `stream`).
+  result_t
+  operator() (std::uint64_t index, std::uint64_t stream = 0) const {
+    result_t c {static_cast<std::uint32_t> (index),
+		static_cast<std::uint32_t> (index >> 32),
+		static_cast<std::uint32_t> (stream),
+		static_cast<std::uint32_t> (stream >> 32)};
+    std::array<std::uint32_t, 2> k = key;
+    for (int r = 0; r < 10; ++r) {
+      if (r > 0) {
+	k[0] += W0;
+	k[1] += W1;
+      }
+      const std::uint64_t p0 = std::uint64_t (M0) * c[0];
+      const std::uint64_t p1 = std::uint64_t (M1) * c[2];
+      c = {static_cast<std::uint32_t> (p1 >> 32) ^ c[1] ^ k[0],
+	   static_cast<std::uint32_t> (p1),
+	   static_cast<std::uint32_t> (p0 >> 32) ^ c[3] ^ k[1],
+	   static_cast<std::uint32_t> (p0)};
+    }
+    return c;
+  };
+
+  //! @brief Two uniform doubles in [0, 1) for counter (`index`, `stream`).
+  std::array<double, 2>
+  uniform2 (std::uint64_t index, std::uint64_t stream = 0) const {
+    const result_t w = (*this) (index, stream);
+    return {to_unit (w[0], w[1]), to_unit (w[2], w[3])};
+  };
+
+  //! @brief Uniform double in [0, 1) from the top 53 bits of two words.
+  static double
+  to_unit (std::uint32_t hi, std::uint32_t lo) {
+    const std::uint64_t bits = (std::uint64_t (hi) << 32) | lo;
+    return static_cast<double> (bits >> 11) * (1.0 / 9007199254740992.0);
+  };
+
+private:
+
+  static constexpr std::uint32_t M0 = 0xD2511F53;
+  static constexpr std::uint32_t M1 = 0xCD9E8D57;
+  static constexpr std::uint32_t W0 = 0x9E3779B9;
+  static constexpr std::uint32_t W1 = 0xBB67AE85;
+
+  std::array<std::uint32_t, 2> key;
+
+};
+
+#endif /* PHILOX_H */
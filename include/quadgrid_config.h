@@ -0,0 +1,59 @@
+#ifndef QUADGRID_CONFIG_H
+#define QUADGRID_CONFIG_H
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+//! @file quadgrid_config.h
+//! @brief Index types, selected at compile time.
+//!
+//! `QUADGRID_IDX_T` is the signed integer type of cell, node and
+//! particle indices (`quadgrid_t::idx_t`, `particles_t::idx_t`),
+//! `int` unless defined otherwise, e.g.
+//!
+//!     -DQUADGRID_IDX_T=std::int64_t
+//!
+//! for grids with more than 2^31 nodes or more than 2^31 particles.
+//!
+//! With 64 bit indices, define `QUADGRID_COMPACT_BINNING` to store
+//! particle indices in the binning index (`particles_t::grd_to_ptcl`)
+//! as 32 bit integers, which halves its size and the memory traffic
+//! of transfers as long as there are fewer than 2^31 particles.
+
+#ifndef QUADGRID_IDX_T
+#define QUADGRID_IDX_T int
+#endif
+
+namespace QUADGRID_CONFIG {
+
+  using idx_t = QUADGRID_IDX_T;
+
+  static_assert (std::is_integral<idx_t>::value && std::is_signed<idx_t>::value,
+		 "QUADGRID_IDX_T must be a signed integer type");
+
+#ifdef QUADGRID_COMPACT_BINNING
+  using bin_idx_t = std::int32_t;
+#else
+  using bin_idx_t = idx_t;
+#endif
+
+  //! @brief Product `a * b` as an `I`, throws `std::overflow_error`
+  //! naming `what` if it is not representable.
+  template <class I>
+  I
+  checked_product (std::int64_t a, std::int64_t b, const char *what) {
+    if (a < 0 || b < 0
+	|| (a > 0 && b > std::numeric_limits<std::int64_t>::max () / a)
+	|| a * b > static_cast<std::int64_t> (std::numeric_limits<I>::max ()))
+      throw std::overflow_error (std::string (what)
+				 + " does not fit the index type,"
+				 " rebuild with a wider QUADGRID_IDX_T");
+    return static_cast<I> (a * b);
+  }
+
+}
+
+#endif /* QUADGRID_CONFIG_H */
@@ -2,11 +2,19 @@
 #define QUADGRID_H
 
 #include <algorithm>
+#include <ascii_format.h>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
+#include <instrumentation.h>
 #include <json.hpp>
 #include <map>
+#include <memory_report.h>
 #include <mpi.h>
+#include <numeric>
+#include <quadgrid_config.h>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 template <class distributed_vector>
@@ -16,10 +24,22 @@ quadgrid_t
 
 public:
 
-  using idx_t = int;
+  /// Index type, see quadgrid_config.h.
+  using idx_t = QUADGRID_CONFIG::idx_t;
+
+  /// Cell index returned by `sub2gind` for subscripts outside the grid.
+  static constexpr idx_t out_of_grid = -1;
 
   class  cell_t;
 
+  /// Numbering of cells and nodes. `column_major` is `r + numrows * c`
+  /// for cells and `r + (numrows + 1) * c` for nodes, `morton` (Z-order)
+  /// and `hilbert` number cells and nodes along a space filling curve,
+  /// so that cells (and nodes) close in space are close in memory
+  /// in both directions and contiguous index ranges are compact
+  /// regions of the grid.
+  enum class ordering_t { column_major, morton, hilbert };
+
   struct grid_properties_t {
     idx_t             numrows;
     idx_t             numcols;
@@ -30,6 +50,35 @@ public:
     idx_t             end_cell_col;
     idx_t             start_owned_nodes;
     idx_t             num_owned_nodes;
+    ordering_t        ordering;
+    std::vector<idx_t> cell_index;     /// column-major position -> cell index.
+    std::vector<idx_t> cell_position;  /// cell index -> column-major position.
+    std::vector<idx_t> node_index;     /// column-major position -> node index.
+    std::vector<idx_t> node_position;  /// node index -> column-major position.
+
+    idx_t
+    cell_idx (idx_t r, idx_t c) const {
+      if (r < 0 || r >= numrows || c < 0 || c >= numcols)
+	return out_of_grid;
+      const idx_t cm = r + numrows * c;
+      return ordering == ordering_t::column_major ? cm : cell_index[cm];
+    }
+
+    idx_t
+    cell_pos (idx_t idx) const {
+      return ordering == ordering_t::column_major ? idx : cell_position[idx];
+    }
+
+    idx_t
+    node_idx (idx_t r, idx_t c) const {
+      const idx_t cm = r + (numrows + 1) * c;
+      return ordering == ordering_t::column_major ? cm : node_index[cm];
+    }
+
+    idx_t
+    node_pos (idx_t idx) const {
+      return ordering == ordering_t::column_major ? idx : node_position[idx];
+    }
   };
 
   void
@@ -46,8 +95,15 @@ public:
     q.start_cell_col = 0;
     q.end_cell_col = q.numcols - 1;
     q.start_owned_nodes = 0;
-    q.num_owned_nodes = (q.numrows+1)*(q.numcols+1);
-
+    q.num_owned_nodes = QUADGRID_CONFIG::checked_product<idx_t>
+      (q.numrows + std::int64_t (1), q.numcols + std::int64_t (1),
+       "number of grid nodes");
+
+    q.ordering = ordering_t::column_major;
+    if (j.contains ("ordering"))
+      q.ordering = ordering_from_string (j.at ("ordering").get<std::string> ());
+    build_ordering (q);
+    lumped_mass_cache.clear ();
   }
   
   class
@@ -128,7 +184,7 @@ public:
     static constexpr idx_t NOT_ON_BOUNDARY = -1;
 
     cell_t (const grid_properties_t& _gp)
-      : grid_properties (_gp), rowidx (0), colidx (0), is_ghost (false) { };
+      : is_ghost (false), rowidx (0), colidx (0), grid_properties (_gp) { };
 
     double
     p (idx_t i, idx_t j) const;
@@ -208,17 +264,26 @@ public:
 
     idx_t
     sub2gind (idx_t r, idx_t c) const {
-      return  (r + grid_properties.numrows * c);
+      return grid_properties.cell_idx (r, c);
     }
 
     idx_t
     gind2row (idx_t idx) const {
-      return  (idx / grid_properties.numrows);
+      return grid_properties.cell_pos (idx) % grid_properties.numrows;
     }
 
     idx_t
     gind2col (idx_t idx) const {
-      return  (idx % grid_properties.numrows);
+      return grid_properties.cell_pos (idx) / grid_properties.numrows;
+    }
+
+    /// Global index of the last cell of the sweep.
+    idx_t
+    last_cell_idx () const {
+      if (grid_properties.ordering == ordering_t::column_major)
+	return sub2gind (grid_properties.end_cell_row,
+			 grid_properties.end_cell_col);
+      return grid_properties.numrows * grid_properties.numcols - 1;
     }
 
     void
@@ -231,6 +296,18 @@ public:
 		  grid_properties.start_cell_col);
     };
 
+    /// Move to the cell with global index `idx`.
+    void
+    set (idx_t idx) {
+      const idx_t pos = grid_properties.cell_pos (idx);
+      rowidx = pos % grid_properties.numrows;
+      colidx = pos / grid_properties.numrows;
+      global_cell_idx = idx;
+      local_cell_idx = global_cell_idx -
+	sub2gind (grid_properties.start_cell_row,
+		  grid_properties.start_cell_col);
+    };
+
   private:
 
     bool                     is_ghost;
@@ -268,6 +345,7 @@ public:
     grid_properties.end_cell_col = 0;
     grid_properties.start_owned_nodes = 0;
     grid_properties.num_owned_nodes = 0;
+    grid_properties.ordering = ordering_t::column_major;
   };
 
   /// Ctor that reads grid properties from a json object.
@@ -288,16 +366,73 @@ public:
   set_sizes (idx_t numrows, idx_t numcols,
 	     double hx, double hy);
 
+  /// Select the numbering of cells and nodes, fields indexed
+  /// with the previous numbering must be permuted by the caller.
+  void
+  set_ordering (ordering_t o) {
+    grid_properties.ordering = o;
+    build_ordering (grid_properties);
+    lumped_mass_cache.clear ();
+  };
+
+  ordering_t
+  ordering () const
+  { return grid_properties.ordering; };
+
+  /// Parse "column_major", "morton" or "hilbert".
+  static ordering_t
+  ordering_from_string (const std::string &name);
+
+  static const char *
+  ordering_name (ordering_t o);
+
   void
   vtk_export (const char *filename,
 	      const std::map<std::string,
 	      distributed_vector> & f) const;
 
+  /// Export nodal fields `f` and cell fields `cf`, the latter
+  /// indexed by global cell index (e.g. particle counts).
+  void
+  vtk_export (const char *filename,
+	      const std::map<std::string,
+	      distributed_vector> & f,
+	      const std::map<std::string,
+	      distributed_vector> & cf) const;
+
+  /// Export nodal fields of any type that can be iterated over
+  /// in node order, e.g. `sparse_field_t`.
+  template <class F>
+  void
+  vtk_export (const char *filename,
+	      const std::map<std::string, F> & f) const {
+    write_vtk (filename, f, std::map<std::string, distributed_vector> ());
+  };
+
   void
   octave_ascii_export (const char *filename,
 		       const std::map<std::string,
 		       distributed_vector> & f) const;
   
+  /// Memory held by the grid object.
+  memory_report_t
+  memory_report () const;
+
+  /// Memory held by the grid object and by the fields in `f`.
+  memory_report_t
+  memory_report (const std::map<std::string,
+		 distributed_vector> & f) const;
+
+  /// Cell with global index `idx`. Unlike the cell sweep, which
+  /// moves a cell shared by all iterators, each call returns an
+  /// independent object, so it can be used from several threads.
+  cell_t
+  cell (idx_t idx) const {
+    cell_t c (grid_properties);
+    c.set (idx);
+    return c;
+  };
+
   cell_iterator
   begin_cell_sweep ();
 
@@ -313,7 +448,7 @@ public:
   { return cell_iterator (); };
 
   idx_t
-  num_owned_nodes ()
+  num_owned_nodes () const
   { return grid_properties.num_owned_nodes; };
 
   idx_t
@@ -344,29 +479,90 @@ public:
   hy () const
   { return grid_properties.hy; };
 
+  /// Global index of the cell in row `r` and column `c`,
+  /// `out_of_grid` if there is no such cell.
   idx_t
   sub2gind (idx_t r, idx_t c) const {
-    return  (r + grid_properties.numrows * c);
+    return grid_properties.cell_idx (r, c);
   }
 
   idx_t
   gind2row (idx_t idx) const {
-    return  (idx / grid_properties.numrows);
+    return grid_properties.cell_pos (idx) % grid_properties.numrows;
   }
 
   idx_t
   gind2col (idx_t idx) const {
-    return  (idx % grid_properties.numrows);
+    return grid_properties.cell_pos (idx) / grid_properties.numrows;
+  }
+
+  /// Global index of the node in row `r` and column `c`.
+  idx_t
+  node_sub2gind (idx_t r, idx_t c) const {
+    return grid_properties.node_idx (r, c);
   }
 
+  idx_t
+  node_gind2row (idx_t idx) const {
+    return grid_properties.node_pos (idx) % (grid_properties.numrows + 1);
+  }
+
+  idx_t
+  node_gind2col (idx_t idx) const {
+    return grid_properties.node_pos (idx) / (grid_properties.numrows + 1);
+  }
+
+  /// Lumped (row-sum) mass of node `idx` for bilinear elements,
+  /// `(hx/2)*(hy/2)` times the number of cells sharing the node:
+  /// 4 inside, 2 on edges, 1 at corners.
+  double
+  lumped_mass (idx_t idx) const {
+    const idx_t r = node_gind2row (idx), c = node_gind2col (idx);
+    const int nr = (r == 0 || r == grid_properties.numrows) ? 1 : 2;
+    const int nc = (c == 0 || c == grid_properties.numcols) ? 1 : 2;
+    return (nr * nc) * ((grid_properties.hx / 2.) * (grid_properties.hy / 2.));
+  }
+
+  /// Lumped mass of all nodes, computed on first use and kept until
+  /// sizes or ordering change. The first call must not race with
+  /// other calls.
+  const distributed_vector &
+  lumped_mass () const;
+
   MPI_Comm          comm;
   int               rank;
   int               size;
 
+  /// Timers and counters for the exporters, see instrumentation.h.
+  mutable instrumentation_t stats;
+
 private :
 
+  /// Fill the permutation tables of `q` for `q.ordering`.
+  static void
+  build_ordering (grid_properties_t &q);
+
+  /// Values of `f` moved from index order to column-major
+  /// order, i.e. `out[position[i]] = f[i]`.
+  template <class F>
+  static std::vector<double>
+  to_column_major (const F & f, const std::vector<idx_t> & position) {
+    std::vector<double> out (position.size ());
+    std::size_t ii = 0;
+    for (auto const & v : f)
+      out[position[ii++]] = v;
+    return out;
+  };
+
+  template <class F, class CF>
+  void
+  write_vtk (const char *filename,
+	     const std::map<std::string, F> & f,
+	     const std::map<std::string, CF> & cf) const;
+
   mutable cell_t   current_cell;
   mutable cell_t   current_neighbor;
+  mutable distributed_vector lumped_mass_cache;
 
   grid_properties_t grid_properties;
 
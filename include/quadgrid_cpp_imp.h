@@ -30,7 +30,121 @@ quadgrid_t<T>::set_sizes (idx_t numrows, idx_t numcols,
   grid_properties.start_cell_col = 0;
   grid_properties.end_cell_col = numcols - 1;
   grid_properties.start_owned_nodes = 0;
-  grid_properties.num_owned_nodes = (numrows+1)*(numcols+1);
+  // nodes outnumber cells, checking them is enough to make all
+  // index arithmetic on the grid safe
+  grid_properties.num_owned_nodes = QUADGRID_CONFIG::checked_product<idx_t>
+    (numrows + std::int64_t (1), numcols + std::int64_t (1),
+     "number of grid nodes");
+  build_ordering (grid_properties);
+  lumped_mass_cache.clear ();
+}
+
+
+template <class T>
+const T &
+quadgrid_t<T>::lumped_mass () const {
+  const idx_t n = num_global_nodes ();
+  if (static_cast<idx_t> (lumped_mass_cache.size ()) != n) {
+    lumped_mass_cache.resize (n);
+#pragma omp parallel for schedule(static)
+    for (idx_t ii = 0; ii < n; ++ii)
+      lumped_mass_cache[ii] = lumped_mass (ii);
+  }
+  return lumped_mass_cache;
+}
+
+
+
+template <class T>
+typename quadgrid_t<T>::ordering_t
+quadgrid_t<T>::ordering_from_string (const std::string &name) {
+  if (name == "column_major")
+    return ordering_t::column_major;
+  if (name == "morton")
+    return ordering_t::morton;
+  if (name == "hilbert")
+    return ordering_t::hilbert;
+  throw std::invalid_argument ("unknown grid ordering " + name);
+}
+
+
+
+template <class T>
+const char *
+quadgrid_t<T>::ordering_name (ordering_t o) {
+  switch (o) {
+  case ordering_t::morton :
+    return "morton";
+  case ordering_t::hilbert :
+    return "hilbert";
+  default :
+    return "column_major";
+  }
+}
+
+
+
+template <class T>
+void
+quadgrid_t<T>::build_ordering (grid_properties_t &q) {
+
+  q.cell_index.clear ();
+  q.cell_position.clear ();
+  q.node_index.clear ();
+  q.node_position.clear ();
+  if (q.ordering == ordering_t::column_major)
+    return;
+
+  // position of (r, c) along the curve on the smallest power of two
+  // square containing the grid, the index of a point is its rank
+  // among the points of the grid
+  auto curve_key = [&q] (idx_t r, idx_t c, idx_t n) -> std::uint64_t {
+    std::uint64_t key = 0;
+    if (q.ordering == ordering_t::morton) {
+      for (idx_t b = 0; (idx_t (1) << b) < n; ++b)
+	key |= (std::uint64_t ((c >> b) & 1) << (2 * b))
+	  | (std::uint64_t ((r >> b) & 1) << (2 * b + 1));
+    }
+    else {
+      idx_t x = c, y = r;
+      for (idx_t s = n / 2; s > 0; s /= 2) {
+	const idx_t rx = (x & s) > 0, ry = (y & s) > 0;
+	key += std::uint64_t (s) * s * ((3 * rx) ^ ry);
+	if (ry == 0) {
+	  if (rx == 1) {
+	    x = s - 1 - (x & (s - 1));
+	    y = s - 1 - (y & (s - 1));
+	  }
+	  std::swap (x, y);
+	}
+	x &= s - 1;
+	y &= s - 1;
+      }
+    }
+    return key;
+  };
+
+  auto number = [&curve_key] (idx_t nr, idx_t nc,
+			      std::vector<idx_t> &index,
+			      std::vector<idx_t> &position) {
+    idx_t n = 1;
+    while (n < std::max (nr, nc))
+      n *= 2;
+    std::vector<std::uint64_t> key (static_cast<std::size_t> (nr) * nc);
+    for (idx_t c = 0; c < nc; ++c)
+      for (idx_t r = 0; r < nr; ++r)
+	key[r + nr * c] = curve_key (r, c, n);
+    position.resize (key.size ());
+    std::iota (position.begin (), position.end (), 0);
+    std::sort (position.begin (), position.end (),
+	       [&key] (idx_t a, idx_t b) { return key[a] < key[b]; });
+    index.resize (key.size ());
+    for (idx_t ii = 0; ii < static_cast<idx_t> (position.size ()); ++ii)
+      index[position[ii]] = ii;
+  };
+
+  number (q.numrows, q.numcols, q.cell_index, q.cell_position);
+  number (q.numrows + 1, q.numcols + 1, q.node_index, q.node_position);
 }
 
 
@@ -40,18 +154,11 @@ void
 quadgrid_t<T>::cell_iterator::operator++ () {
   static idx_t tmp;
   if (data != nullptr) {
-    tmp =  data->rowidx + data->num_rows () *  data->colidx + 1;
-    if (tmp > (data->end_cell_row () +
-	       data->num_rows () * data->end_cell_col ()))
+    tmp =  data->global_cell_idx + 1;
+    if (tmp > data->last_cell_idx ())
       data = nullptr;
-    else {
-      data->rowidx = tmp % data->num_rows ();
-      data->colidx = tmp / data->num_rows ();
-      data->global_cell_idx = tmp;
-      data->local_cell_idx = tmp -
-	(data->start_cell_row () +
-	 data->num_rows () * data->start_cell_col ());
-    }
+    else
+      data->set (tmp);
   }
 };
 
@@ -154,31 +261,45 @@ quadgrid_t<T>::num_local_nodes () const {
 
 
 
+template <class T>
+memory_report_t
+quadgrid_t<T>::memory_report () const {
+  // cells are computed on the fly, the object itself is all there is
+  memory_report_t r;
+  r.add ("object", "quadgrid_t", sizeof (quadgrid_t), sizeof (quadgrid_t));
+  r.add_vector ("ordering", "cell_index", grid_properties.cell_index);
+  r.add_vector ("ordering", "cell_position", grid_properties.cell_position);
+  r.add_vector ("ordering", "node_index", grid_properties.node_index);
+  r.add_vector ("ordering", "node_position", grid_properties.node_position);
+  r.add_vector ("mass", "lumped_mass", lumped_mass_cache);
+  return r;
+}
+
+
+template <class T>
+memory_report_t
+quadgrid_t<T>::memory_report (const std::map<std::string, T> & f) const {
+  memory_report_t r = memory_report ();
+  for (auto const & ii : f)
+    r.add_vector ("fields", ii.first, ii.second);
+  const auto keys = memory_report_t::column_map_bytes (f);
+  r.add ("fields", "(map nodes and keys)", keys, keys);
+  return r;
+}
+
+
+
 
 
 
 template <class T>
 typename quadgrid_t<T>::idx_t
 quadgrid_t<T>::cell_t::gt (typename quadgrid_t<T>::idx_t inode) const {
-  static idx_t bottom_left = 0;
   // should check that inode < 4 in an efficient way
-  bottom_left =  row_idx () + col_idx () * (num_rows () + 1);
-  switch (inode) {
-  case 0 :
-    return (bottom_left);
-    break;
-  case 1 :
-    return (bottom_left + 1);
-    break;
-  case 2 :
-    return (bottom_left + (num_rows () + 1));
-    break;
-  case 3 :
-    return (bottom_left + (num_rows () + 2));
-    break;
-  default :
+  if (inode < 0 || inode >= nodes_per_cell)
     return -1;
-  }
+  return grid_properties.node_idx (row_idx () + inode % 2,
+				   col_idx () + inode / 2);
 }
 
 
@@ -355,7 +476,27 @@ template <class T>
 void
 quadgrid_t<T>::vtk_export (const char *filename,
 			   const std::map<std::string, T> & f) const {
+  vtk_export (filename, f, std::map<std::string, T> ());
+}
+
+
+template <class T>
+void
+quadgrid_t<T>::vtk_export (const char *filename,
+			   const std::map<std::string, T> & f,
+			   const std::map<std::string, T> & cf) const {
+  write_vtk (filename, f, cf);
+}
+
 
+template <class T>
+template <class F, class CF>
+void
+quadgrid_t<T>::write_vtk (const char *filename,
+			  const std::map<std::string, F> & f,
+			  const std::map<std::string, CF> & cf) const {
+
+  QUADGRID_PHASE (stats, phase_t::vtk_export);
   std::ofstream ofs (filename, std::ofstream::out);
 
   // This is the XML format of a VTS file to write :
@@ -371,16 +512,45 @@ quadgrid_t<T>::vtk_export (const char *filename,
   }
   ofs  << "\">\n";
 
+  // the structured grid expects values in column-major order
+  const bool permute = ordering () != ordering_t::column_major;
+
   for (auto const & ii : f) {
     ofs << "        <DataArray type=\"Float64\" Name=\"" << ii.first <<"\" format=\"ascii\">\n        ";
-    for (auto const & jj : ii.second) {
-      ofs << jj << " ";
-    }
+    if (permute)
+      for (auto const & jj : to_column_major (ii.second, grid_properties.node_position))
+	ofs << jj << " ";
+    else
+      for (auto const & jj : ii.second) {
+	ofs << jj << " ";
+      }
     ofs << std::endl << "        </DataArray>" << std::endl;
   }
 
   ofs << "      </PointData>\n";
 
+  if (! cf.empty ()) {
+    ofs << "      <CellData Scalars=\"";
+    for (auto const & ii : cf) {
+      ofs << ii.first << ",";
+    }
+    ofs  << "\">\n";
+
+    for (auto const & ii : cf) {
+      ofs << "        <DataArray type=\"Float64\" Name=\"" << ii.first <<"\" format=\"ascii\">\n        ";
+      if (permute)
+	for (auto const & jj : to_column_major (ii.second, grid_properties.cell_position))
+	  ofs << jj << " ";
+      else
+	for (auto const & jj : ii.second) {
+	  ofs << jj << " ";
+	}
+      ofs << std::endl << "        </DataArray>" << std::endl;
+    }
+
+    ofs << "      </CellData>\n";
+  }
+
   ofs << "      <Points>\n        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"ascii\">\n";
   for (idx_t ii = 0; ii <= num_cols(); ++ii) {
     ofs << "          ";
@@ -397,6 +567,7 @@ quadgrid_t<T>::vtk_export (const char *filename,
   </StructuredGrid>\n\
 </VTKFile>\n";
 
+  QUADGRID_COUNT (bytes, ofs.tellp ());
   ofs.close ();
 }
 
@@ -407,38 +578,46 @@ quadgrid_t<T>::octave_ascii_export
 (const char *filename,
  std::map<std::string, T> const & vars) const {
 
+  QUADGRID_PHASE (stats, phase_t::octave_ascii_export);
   std::ofstream os (filename, std::ofstream::out);
   
   os << "# name: p" << std::endl
      << "# type: matrix" << std::endl
      << "# rows: 2" << std::endl
-     << "# columns: " << num_owned_nodes () << std::endl;
+     << "# columns: " << num_global_nodes () << std::endl;
 
-  for (idx_t jj = 0; jj < num_cols () + 1; ++jj) {
-    for (idx_t ii = 0; ii < num_rows () + 1; ++ii) {
-      os  << std::setprecision(16) << jj*hx() << " ";
-    }
-  }
+  const double dx = hx (), dy = hy ();
+
+  ASCII_FORMAT::write_chunked
+    (os, num_global_nodes (),
+     [this, dx] (std::string & buf, std::size_t inode) {
+       ASCII_FORMAT::append (buf, node_gind2col (static_cast<idx_t> (inode)) * dx);
+       buf += ' ';
+     });
   os << std::endl;
 
-  for (idx_t jj = 0; jj < num_cols () + 1; ++jj) {
-    for (idx_t ii = 0; ii < num_rows () + 1; ++ii) {
-      os  << std::setprecision(16) << ii*hy() << " ";
-    }
-  }
+  ASCII_FORMAT::write_chunked
+    (os, num_global_nodes (),
+     [this, dy] (std::string & buf, std::size_t inode) {
+       ASCII_FORMAT::append (buf, node_gind2row (static_cast<idx_t> (inode)) * dy);
+       buf += ' ';
+     });
   os << std::endl;
   
   os << "# name: t" << std::endl
      << "# type: matrix" << std::endl
      << "# rows: 4" << std::endl
      << "# columns: " << num_local_cells () << std::endl;
-  for (auto inode = 0;
-       inode < quadgrid_t<std::vector<double>>::cell_t::nodes_per_cell;
-       ++inode) {
-    for (auto icell = begin_cell_sweep ();
-	 icell != end_cell_sweep (); ++icell) {
-      os  << std::setprecision(16) << icell->gt(inode) << " ";
-    }
+
+  for (idx_t inode = 0; inode < cell_t::nodes_per_cell; ++inode) {
+    ASCII_FORMAT::write_chunked
+      (os, num_local_cells (),
+       [this, inode] (std::string & buf, std::size_t icell) {
+	 const idx_t r = gind2row (static_cast<idx_t> (icell));
+	 const idx_t c = gind2col (static_cast<idx_t> (icell));
+	 ASCII_FORMAT::append (buf, node_sub2gind (r + inode % 2, c + inode / 2));
+	 buf += ' ';
+       });
     os << std::endl;
   }
   
@@ -455,13 +634,18 @@ quadgrid_t<T>::octave_ascii_export
        << "# type: matrix" << std::endl
        << "# rows: 1" << std::endl
        << "# columns: " << ii.second.size () << std::endl;
-    for (auto const & kk : ii.second) {
-      os << std::setprecision(16) << kk << " ";
-    }
+    auto const data = std::begin (ii.second);
+    ASCII_FORMAT::write_chunked
+      (os, std::size (ii.second),
+       [&data] (std::string & buf, std::size_t kk) {
+	 ASCII_FORMAT::append (buf, data[kk]);
+	 buf += ' ';
+       });
     os << std::endl;
   }
   os << std::endl;
 
+  QUADGRID_COUNT (bytes, os.tellp ());
   os.close ();
 }
 
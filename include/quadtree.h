@@ -0,0 +1,259 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include <cstdint>
+#include <map>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! @brief Quadtree refinement of a uniform grid.
+
+//! Each cell of a base `quadgrid_t` is the root of a quadtree, leaves
+//! are refined where particles are dense and the tree is kept 2:1
+//! balanced across edges, so each edge of a leaf has at most one
+//! hanging node at its midpoint. The value of the bilinear basis at
+//! a hanging node is constrained to the average of the two endpoints
+//! of the coarse edge it lies on, so fields are continuous.
+//!
+//! Leaves offer the same interface as the cells of `quadgrid_t`
+//! (`p`, `gt`, `shp`, `shg`, `get_global_cell_idx`) and are visited
+//! via `begin_cell_sweep` / `end_cell_sweep`, `p2g` and `g2p` transfer
+//! particle properties to and from the nodes of the leaves.
+class
+quadtree_t {
+
+public:
+
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+  static constexpr idx_t nodes_per_cell = 4;
+  static constexpr idx_t NOT_HANGING = -1;
+
+  //! @brief Leaf of the tree.
+  class
+  cell_t {
+
+  public:
+
+    cell_t (const quadtree_t &tree_, idx_t leaf_)
+      : tree (&tree_), leaf (leaf_) { };
+
+    //! Coordinate `i` (0 = x, 1 = y) of node `j`.
+    double
+    p (idx_t i, idx_t j) const;
+
+    //! Global index of node `i`, nodes are numbered as in `quadgrid_t`
+    //! cells: 0 bottom-left, 1 top-left, 2 bottom-right, 3 top-right.
+    idx_t
+    gt (idx_t i) const
+    { return tree->leaf_nodes[leaf * nodes_per_cell + i]; };
+
+    double
+    shp (double x, double y, idx_t inode) const;
+
+    double
+    shg (double x, double y, idx_t idir, idx_t inode) const;
+
+    idx_t
+    get_global_cell_idx () const
+    { return leaf; };
+
+    //! refinement level, 0 for cells of the base grid.
+    idx_t
+    level () const;
+
+    double
+    hx () const;
+
+    double
+    hy () const;
+
+  private:
+
+    friend class quadtree_t;
+    const quadtree_t  *tree;
+    idx_t              leaf;
+  };
+
+  //! @brief Iterator over leaves.
+  class
+  cell_iterator {
+
+  public:
+
+    cell_iterator (const quadtree_t &tree, idx_t leaf)
+      : cell (tree, leaf) { };
+
+    cell_iterator &
+    operator++ ()
+    { ++cell.leaf; return *this; };
+
+    const cell_t &
+    operator* () const
+    { return cell; };
+
+    const cell_t *
+    operator-> () const
+    { return &cell; };
+
+    bool
+    operator== (const cell_iterator &other) const
+    { return cell.leaf == other.cell.leaf; };
+
+    bool
+    operator!= (const cell_iterator &other) const
+    { return cell.leaf != other.cell.leaf; };
+
+  private:
+
+    cell_t cell;
+  };
+
+  //! @brief Unrefined tree, one leaf per cell of `base`.
+  //! @param max_level_ maximum number of refinements of a base cell,
+  //! at most 20; throws `std::invalid_argument` if the finest level
+  //! has too many cells for 64 bit lattice coordinates.
+  explicit
+  quadtree_t (const quadgrid_t<std::vector<double>> &base,
+	      idx_t max_level_ = 8);
+
+  //! @brief Refine where particles are dense.
+
+  //! Leaves containing more than `max_particles_per_leaf` particles
+  //! are split recursively (up to `max_level` refinements), then the
+  //! tree is 2:1 balanced, nodes are numbered and particles binned.
+  void
+  refine (const particles_t &p, idx_t max_particles_per_leaf);
+
+  //! @brief Split leaf `leaf` into four children.
+
+  //! Invalidates node numbering and binning, call `update` after
+  //! all leaves have been split.
+  void
+  split (idx_t leaf);
+
+  //! @brief Balance the tree, number nodes and find hanging nodes.
+  void
+  update ();
+
+  //! @brief Assign particles of `p` to leaves.
+  void
+  bin (const particles_t &p);
+
+  //! @brief Leaf containing point (`x`, `y`).
+  idx_t
+  locate (double x, double y) const;
+
+  cell_iterator
+  begin_cell_sweep () const
+  { return cell_iterator (*this, 0); };
+
+  cell_iterator
+  end_cell_sweep () const
+  { return cell_iterator (*this, num_global_cells ()); };
+
+  //! number of leaves.
+  idx_t
+  num_global_cells () const
+  { return static_cast<idx_t> (leaves.size ()); };
+
+  //! number of nodes, hanging nodes included.
+  idx_t
+  num_global_nodes () const
+  { return static_cast<idx_t> (node_x.size ()); };
+
+  //! number of hanging nodes.
+  idx_t
+  num_hanging_nodes () const;
+
+  //! @brief Nodes constraining node `inode`, `NOT_HANGING` if free.
+  std::pair<idx_t, idx_t>
+  constraint (idx_t inode) const
+  { return {hang_a[inode], hang_b[inode]}; };
+
+  //! @brief Set hanging nodes to the average of their constraining nodes.
+  void
+  make_conforming (std::vector<double> &v) const;
+
+  //! @brief Lumped mass of the conforming basis.
+  void
+  build_mass ();
+
+  //! @brief Map particle variables to the nodes of the leaves.
+
+  //! Contributions to hanging nodes are distributed to the nodes
+  //! constraining them. If `apply_mass` is true, values are divided
+  //! by the lumped mass (see `build_mass`) and hanging nodes are then
+  //! set by interpolation, otherwise hanging nodes are left at zero.
+  void
+  p2g (const particles_t &p,
+       std::map<std::string, std::vector<double>> &vars,
+       const std::vector<std::string> &pvarnames,
+       const std::vector<std::string> &gvarnames,
+       bool apply_mass = false) const;
+
+  //! @brief Interpolate nodal fields at particle positions.
+
+  //! Values at hanging nodes are taken from the constraint, so
+  //! fields need not be conforming.
+  void
+  g2p (particles_t &p,
+       const std::map<std::string, std::vector<double>> &vars,
+       const std::vector<std::string> &gvarnames,
+       const std::vector<std::string> &pvarnames,
+       assignment_t OP = ASSIGNMENT_OPS::EQ) const;
+
+  //! @brief Export leaves and nodal fields as a VTK unstructured grid.
+  void
+  vtk_export (const char *filename,
+	      const std::map<std::string, std::vector<double>> &f) const;
+
+  //! leaf/particles connectivity, filled by `bin`.
+  std::map<idx_t, std::vector<idx_t>>  leaf_to_ptcl;
+
+  //! lumped mass, filled by `build_mass`.
+  std::vector<double>                  M;
+
+private:
+
+  //! a node of the tree, leaf if `child` is negative.
+  struct
+  tree_node_t {
+    idx_t         level;
+    std::int64_t  i;       //!< column of the node among those of its level.
+    std::int64_t  j;       //!< row of the node among those of its level.
+    idx_t         child;   //!< index of the first of four children, or -1.
+    idx_t         leaf;    //!< index in `leaves` if a leaf, or -1.
+  };
+
+  idx_t
+  locate_lattice (std::int64_t X, std::int64_t Y) const;
+
+  std::uint64_t
+  lattice_key (std::int64_t X, std::int64_t Y) const
+  { return static_cast<std::uint64_t> (X) * (lattice_rows + 1) + Y; };
+
+  //! split tree node `n`, returns the index of its first child.
+  idx_t
+  split_node (idx_t n);
+
+  void
+  collect_leaves ();
+
+  const quadgrid_t<std::vector<double>>  &base;
+  const idx_t                             max_level;
+  std::int64_t                            lattice_rows;  //!< lattice points per column, minus one.
+  std::vector<tree_node_t>                tree_nodes;    //!< roots first, in base cell order.
+  std::vector<idx_t>                      leaves;        //!< tree node of each leaf.
+  std::vector<idx_t>                      leaf_nodes;    //!< global nodes of each leaf.
+  std::vector<double>                     node_x;
+  std::vector<double>                     node_y;
+  std::vector<idx_t>                      hang_a;
+  std::vector<idx_t>                      hang_b;
+
+};
+
+#endif /* QUADTREE_H */
@@ -0,0 +1,224 @@
+#ifndef SPARSE_FIELD_H
+#define SPARSE_FIELD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory_report.h>
+#include <quadgrid_cpp.h>
+#include <string>
+#include <vector>
+
+//! @brief Nodal field stored in tiles allocated on demand.
+
+//! The nodes of the grid are split in square tiles of
+//! `tile_size` x `tile_size` nodes, storage for a tile is allocated
+//! only when one of its nodes is written via `touch`, untouched
+//! nodes read as zero. Tiles are looked up through a page table and
+//! are taken from (and returned to) a pool, so memory and zeroing
+//! cost of a field scale with the region actually covered by
+//! particles rather than with the size of the grid.
+//!
+//! Node indices are the same as for dense fields on the grid the
+//! field was built from (see `quadgrid_t::ordering_t`), or
+//! `r + c * (numrows + 1)` for fields built from the grid sizes.
+//! References returned by `touch` are invalidated by the allocation
+//! of further tiles.
+class
+sparse_field_t {
+
+public:
+
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+  static constexpr idx_t tile_size = 8;                      //!< nodes per tile side.
+  static constexpr idx_t tile_nodes = tile_size * tile_size; //!< nodes per tile.
+  static constexpr idx_t no_tile = -1;                       //!< page of untouched tiles.
+
+  //! @brief Iterator over the values of all nodes, in node index order.
+  class
+  const_iterator {
+
+  public:
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = double;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const double *;
+    using reference = double;
+
+    const_iterator (const sparse_field_t *f_, idx_t inode_)
+      : f (f_), inode (inode_) { };
+
+    double
+    operator* () const
+    { return (*f)[inode]; };
+
+    const_iterator &
+    operator++ ()
+    { ++inode; return *this; };
+
+    bool
+    operator== (const const_iterator &other) const
+    { return inode == other.inode; };
+
+    bool
+    operator!= (const const_iterator &other) const
+    { return inode != other.inode; };
+
+  private:
+
+    const sparse_field_t *f;
+    idx_t                 inode;
+  };
+
+  //! @brief Empty field on the nodes of `grid`.
+  explicit
+  sparse_field_t (const quadgrid_t<std::vector<double>> &grid);
+
+  //! @brief Empty field on the nodes of a grid with
+  //! `numrows` x `numcols` cells.
+  sparse_field_t (idx_t numrows, idx_t numcols);
+
+  //! @brief Value at node (`r`, `c`), zero if its tile is not allocated.
+  double
+  at (idx_t r, idx_t c) const {
+    const idx_t t = page_table[tile_index (r, c)];
+    return t == no_tile ? 0. : pool[t * tile_nodes + local_index (r, c)];
+  };
+
+  //! @brief Value at node `inode`, zero if its tile is not allocated.
+  double
+  operator[] (idx_t inode) const
+  { return at (node_row (inode), node_col (inode)); };
+
+  //! @brief Writable reference to node (`r`, `c`), allocates its tile
+  //! (zero initialized) if needed.
+  double &
+  touch (idx_t r, idx_t c) {
+    const idx_t page = tile_index (r, c);
+    idx_t t = page_table[page];
+    if (t == no_tile)
+      t = allocate_tile (page);
+    return pool[t * tile_nodes + local_index (r, c)];
+  };
+
+  //! @brief Writable reference to node `inode`, allocates its tile
+  //! (zero initialized) if needed.
+  double &
+  touch (idx_t inode)
+  { return touch (node_row (inode), node_col (inode)); };
+
+  //! @brief Invoke `f (inode, value)` for each node of the allocated
+  //! tiles, `value` is a writable reference.
+  template <typename F>
+  void
+  for_each (F &&f)
+  { visit (*this, f); };
+
+  //! @brief Invoke `f (inode, value)` for each node of the allocated tiles.
+  template <typename F>
+  void
+  for_each (F &&f) const
+  { visit (*this, f); };
+
+  //! @brief Set the field to zero, returning all tiles to the pool.
+  void
+  clear ();
+
+  //! @brief Release the memory of pooled (unused) tiles.
+  void
+  shrink_to_fit ();
+
+  //! @brief Dense copy of the field, in node index order.
+  std::vector<double>
+  to_dense () const;
+
+  //! number of nodes, as for a dense field.
+  std::size_t
+  size () const
+  { return static_cast<std::size_t> (nnr) * nnc; };
+
+  const_iterator
+  begin () const
+  { return const_iterator (this, 0); };
+
+  const_iterator
+  end () const
+  { return const_iterator (this, static_cast<idx_t> (size ())); };
+
+  //! number of tiles covering the grid.
+  idx_t
+  num_tiles () const
+  { return static_cast<idx_t> (page_table.size ()); };
+
+  //! number of tiles currently allocated.
+  idx_t
+  num_allocated_tiles () const
+  { return static_cast<idx_t> (tile_page.size () - free_tiles.size ()); };
+
+  //! number of tiles in the pool, allocated or free.
+  idx_t
+  num_pooled_tiles () const
+  { return static_cast<idx_t> (tile_page.size ()); };
+
+  //! @brief Add the memory held by the field to a report.
+  void
+  memory_report (memory_report_t &r, const std::string &name) const;
+
+private:
+
+  idx_t
+  tile_index (idx_t r, idx_t c) const
+  { return (r / tile_size) + ntr * (c / tile_size); };
+
+  static idx_t
+  local_index (idx_t r, idx_t c)
+  { return (r % tile_size) + tile_size * (c % tile_size); };
+
+  idx_t
+  allocate_tile (idx_t page);
+
+  idx_t
+  node_index (idx_t r, idx_t c) const
+  { return grid ? grid->node_sub2gind (r, c) : r + c * nnr; };
+
+  idx_t
+  node_row (idx_t inode) const
+  { return grid ? grid->node_gind2row (inode) : inode % nnr; };
+
+  idx_t
+  node_col (idx_t inode) const
+  { return grid ? grid->node_gind2col (inode) : inode / nnr; };
+
+  template <typename S, typename F>
+  static void
+  visit (S &self, F &f) {
+    for (idx_t t = 0; t < static_cast<idx_t> (self.tile_page.size ()); ++t) {
+      const idx_t page = self.tile_page[t];
+      if (page == no_tile)
+	continue;
+      const idx_t r0 = (page % self.ntr) * tile_size;
+      const idx_t c0 = (page / self.ntr) * tile_size;
+      const idx_t rn = std::min (tile_size, self.nnr - r0);
+      const idx_t cn = std::min (tile_size, self.nnc - c0);
+      for (idx_t jj = 0; jj < cn; ++jj)
+	for (idx_t ii = 0; ii < rn; ++ii)
+	  f (self.node_index (r0 + ii, c0 + jj),
+	     self.pool[t * tile_nodes + ii + tile_size * jj]);
+    }
+  };
+
+  const quadgrid_t<std::vector<double>> *grid;  //!< node numbering, column-major if null.
+  idx_t                nnr;          //!< number of node rows.
+  idx_t                nnc;          //!< number of node columns.
+  idx_t                ntr;          //!< number of tile rows.
+  idx_t                ntc;          //!< number of tile columns.
+  std::vector<idx_t>   page_table;   //!< tile (page) -> pool slot.
+  std::vector<idx_t>   tile_page;    //!< pool slot -> tile, `no_tile` if free.
+  std::vector<idx_t>   free_tiles;   //!< free pool slots.
+  std::vector<double>  pool;         //!< tile storage.
+
+};
+
+#endif /* SPARSE_FIELD_H */
@@ -0,0 +1,139 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//! @brief Event tracer producing Chrome trace / Perfetto timelines.
+
+//! Records begin/end spans of library phases with the id of the
+//! thread and the MPI rank that executed them. Each thread appends
+//! to its own buffer, so recording needs no locking. Traces are
+//! written in the Chrome trace event json format, one file per rank,
+//! with the rank used as process id: the files of all ranks can be
+//! merged by concatenating their `traceEvents` arrays and loaded in
+//! `chrome://tracing` or `ui.perfetto.dev`.
+//!
+//! Spans are recorded only if the library is compiled with the
+//! `QUADGRID_TRACE` macro defined and the tracer is enabled at run
+//! time via `tracer_t::instance ().enable ()`.
+class
+tracer_t {
+
+public:
+
+  //! A complete span.
+  struct
+  event_t {
+    const char     *name;   //!< name of the span (a string literal).
+    const char     *cat;    //!< category of the span (a string literal).
+    std::uint64_t   begin;  //!< start time in nanoseconds.
+    std::uint64_t   end;    //!< end time in nanoseconds.
+  };
+
+  //! @brief RAII object recording a span from construction to destruction.
+  class
+  scoped_span_t {
+
+  public:
+
+    scoped_span_t (const char *name_, const char *cat_ = "quadgrid")
+      : name (name_), cat (cat_),
+	begin (tracer_t::instance ().is_enabled () ? now () : 0) { };
+
+    ~scoped_span_t () {
+      if (begin != 0)
+	tracer_t::instance ().record (name, cat, begin, now ());
+    };
+
+  private:
+
+    const char     *name;
+    const char     *cat;
+    std::uint64_t   begin;
+  };
+
+  //! the process-wide tracer.
+  static tracer_t &
+  instance ();
+
+  //! @brief Start recording spans.
+  void
+  enable ()
+  { enabled.store (true, std::memory_order_relaxed); };
+
+  //! @brief Stop recording spans, already recorded ones are kept.
+  void
+  disable ()
+  { enabled.store (false, std::memory_order_relaxed); };
+
+  //! whether spans are currently being recorded.
+  bool
+  is_enabled () const
+  { return enabled.load (std::memory_order_relaxed); };
+
+  //! @brief Append a span to the buffer of the calling thread.
+  void
+  record (const char *name, const char *cat,
+	  std::uint64_t begin, std::uint64_t end);
+
+  //! @brief Discard all recorded spans.
+  void
+  clear ();
+
+  //! @brief Write the trace of this rank to `<prefix>_<rank>.json`.
+
+  //! Must not be invoked while other threads are recording.
+  //! The rank is that in `MPI_COMM_WORLD` if MPI is initialized,
+  //! 0 otherwise. Returns the name of the file written.
+  std::string
+  write (const std::string &prefix) const;
+
+  //! current time in nanoseconds, same clock for all processes on a node.
+  static std::uint64_t
+  now () {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+      (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+  };
+
+private:
+
+  //! spans recorded by one thread.
+  struct
+  buffer_t {
+    int                   tid;
+    std::vector<event_t>  events;
+  };
+
+  tracer_t () : enabled (false) { };
+
+  buffer_t &
+  thread_buffer ();
+
+  std::atomic<bool>                      enabled;
+  mutable std::mutex                     mtx;
+  std::vector<std::unique_ptr<buffer_t>> buffers;
+
+};
+
+//! @name Tracing macros
+//! `QUADGRID_SPAN (name, cat)` records the rest of the enclosing
+//! scope as a span, it expands to nothing unless `QUADGRID_TRACE`
+//! is defined.
+//! @{
+#define QUADGRID_CONCAT_(a, b) a##b
+#define QUADGRID_CONCAT(a, b) QUADGRID_CONCAT_(a, b)
+#ifdef QUADGRID_TRACE
+#define QUADGRID_SPAN(name, cat)					\
+  tracer_t::scoped_span_t QUADGRID_CONCAT (quadgrid_span_, __LINE__) (name, cat)
+#else
+#define QUADGRID_SPAN(name, cat)
+#endif
+//! @}
+
+#endif /* TRACER_H */
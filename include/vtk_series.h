@@ -0,0 +1,125 @@
+#ifndef VTK_SERIES_H
+#define VTK_SERIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <string>
+#include <vector>
+
+//! @brief Writer for time series of grid fields and particles.
+
+//! Each call to `write_step` adds one time step to a ParaView
+//! collection file `<basename>.pvd`, the collection file is updated
+//! in place so it is valid (and can be opened) at any time during
+//! the run.
+//!
+//! Each grid field is stored as a separate part of the collection,
+//! in a VTK ImageData file (`.vti`): geometry of the uniform grid is
+//! fully described by its origin and spacing, so no point coordinates
+//! are written. A field is written only if its content changed since
+//! the last step in which it was written, otherwise the collection
+//! refers to the previously written file.
+//!
+//! Particles are stored in one more part as VTK PolyData (`.vtp`),
+//! only one every `particle_stride` particles is written, to reduce
+//! the size of the output of long runs. As for grid fields, the
+//! particle file is written only if positions or properties of the
+//! particles written changed. Changes are detected by hashing the
+//! data a 64 bit word at a time.
+class
+vtk_series_t {
+
+public:
+
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+  //! @brief Open (and truncate) the collection file `<basename>.pvd`.
+  //! @param basename path and prefix of all output files.
+  //! @param grid_ the grid on which fields are defined.
+  //! @param particle_stride write only one particle every `particle_stride`.
+  vtk_series_t (const std::string &basename,
+		const quadgrid_t<std::vector<double>> &grid_,
+		idx_t particle_stride = 1);
+
+  //! Delete copy constructor.
+  vtk_series_t (const vtk_series_t &) = delete;
+
+  //! Delete assignment operator.
+  vtk_series_t &
+  operator= (const vtk_series_t &) = delete;
+
+  //! @brief Add a time step with grid fields only.
+  void
+  write_step (double time,
+	      const std::map<std::string, std::vector<double>> &vars);
+
+  //! @brief Add a time step with grid fields and particles.
+
+  //! Particle properties listed in `dpropnames` and `ipropnames`
+  //! are written (all of them if both lists are empty).
+  void
+  write_step (double time,
+	      const std::map<std::string, std::vector<double>> &vars,
+	      const particles_t &p,
+	      const std::vector<std::string> &dpropnames = {},
+	      const std::vector<std::string> &ipropnames = {});
+
+  //! number of steps written so far.
+  std::size_t
+  num_steps () const
+  { return step; };
+
+  //! number of data files actually written so far.
+  std::size_t
+  num_files_written () const
+  { return files_written; };
+
+private:
+
+  //! status of one part of the collection.
+  struct
+  part_t {
+    idx_t          index;     //!< part number in the collection.
+    std::uint64_t  hash;      //!< hash of the last data written.
+    std::string    file;      //!< file name relative to the `.pvd`.
+  };
+
+  part_t &
+  get_part (const std::string &name);
+
+  void
+  write_grid_fields (const std::map<std::string, std::vector<double>> &vars,
+		     std::vector<part_t *> &written);
+
+  void
+  write_grid_field (const std::string &name, const std::vector<double> &f,
+		    part_t &part);
+
+  void
+  write_particles (const particles_t &p,
+		   const std::vector<std::string> &dpropnames,
+		   const std::vector<std::string> &ipropnames,
+		   part_t &part);
+
+  void
+  append_to_collection (double time, const std::vector<part_t *> &parts);
+
+  const quadgrid_t<std::vector<double>> &grid;
+  const idx_t                            stride;
+  std::string                            basename;
+  std::string                            stem;
+  std::fstream                           pvd;
+  std::streampos                         footer_pos;
+  std::map<std::string, part_t>          parts;
+  part_t                                 particle_part;
+  idx_t                                  num_parts;
+  std::size_t                            step;
+  std::size_t                            files_written;
+
+};
+
+#endif /* VTK_SERIES_H */
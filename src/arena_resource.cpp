@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+
+#include <arena_resource.h>
+
+namespace {
+
+  std::size_t
+  round_up (std::size_t n, std::size_t a) {
+    return (n + a - 1) & ~(a - 1);
+  }
+
+}
+
+
+arena_resource_t::arena_resource_t (std::size_t chunk_bytes_,
+				    std::size_t alignment_,
+				    bool huge_pages_,
+				    std::pmr::memory_resource *upstream_)
+  : chunk_bytes (chunk_bytes_),
+    align (std::max (alignment_, alignof (std::max_align_t))),
+    huge_pages (huge_pages_), upstream (upstream_) {
+  if ((align & (align - 1)) != 0)
+    throw std::bad_alloc ();
+  if (huge_pages)
+    chunk_bytes = round_up (chunk_bytes, huge_page_size);
+}
+
+
+arena_resource_t::~arena_resource_t () {
+  const std::size_t a = huge_pages ? huge_page_size : align;
+  for (auto const & ii : chunks)
+    upstream->deallocate (ii.first, ii.second.size, a);
+}
+
+
+std::size_t
+arena_resource_t::bytes_reserved () const {
+  std::lock_guard<std::mutex> lock (mtx);
+  return reserved;
+}
+
+
+std::size_t
+arena_resource_t::bytes_allocated () const {
+  std::lock_guard<std::mutex> lock (mtx);
+  return allocated;
+}
+
+
+std::size_t
+arena_resource_t::num_chunks () const {
+  std::lock_guard<std::mutex> lock (mtx);
+  return chunks.size ();
+}
+
+
+char *
+arena_resource_t::new_chunk (std::size_t bytes, bool current) {
+
+  const std::size_t a = huge_pages ? huge_page_size : align;
+  const std::size_t len = round_up (std::max (bytes, chunk_bytes), a);
+  char *base = static_cast<char *> (upstream->allocate (len, a));
+
+#ifdef MADV_HUGEPAGE
+  if (huge_pages)
+    ::madvise (base, len, MADV_HUGEPAGE);
+#endif
+
+  chunks[base] = chunk_t {len, 0, 0, current};
+  reserved += len;
+  return base;
+}
+
+
+void
+arena_resource_t::release (char *base, chunk_t &c) {
+  const std::size_t a = huge_pages ? huge_page_size : align;
+  upstream->deallocate (base, c.size, a);
+  reserved -= c.size;
+  chunks.erase (base);
+}
+
+
+void *
+arena_resource_t::do_allocate (std::size_t bytes, std::size_t alignment) {
+
+  if (alignment > align)
+    return upstream->allocate (bytes, alignment);
+
+  const std::size_t len = round_up (std::max (bytes, std::size_t (1)), align);
+
+  std::lock_guard<std::mutex> lock (mtx);
+
+  // blocks larger than a chunk get their own
+  if (len > chunk_bytes) {
+    char *base = new_chunk (len, false);
+    chunk_t &c = chunks.at (base);
+    c.used = len;
+    ++c.live;
+    allocated += len;
+    return base;
+  }
+
+  if (head == nullptr || chunks.at (head).used + len > chunks.at (head).size) {
+    if (head != nullptr) {
+      chunk_t &old = chunks.at (head);
+      old.current = false;
+      if (old.live == 0)
+	release (head, old);
+    }
+    head = new_chunk (chunk_bytes, true);
+  }
+
+  chunk_t &c = chunks.at (head);
+  void *p = head + c.used;
+  c.used += len;
+  ++c.live;
+  allocated += len;
+  return p;
+}
+
+
+void
+arena_resource_t::do_deallocate (void *p, std::size_t bytes,
+				 std::size_t alignment) {
+
+  if (alignment > align) {
+    upstream->deallocate (p, bytes, alignment);
+    return;
+  }
+
+  const std::size_t len = round_up (std::max (bytes, std::size_t (1)), align);
+  char *q = static_cast<char *> (p);
+
+  std::lock_guard<std::mutex> lock (mtx);
+
+  auto it = chunks.upper_bound (q);
+  if (it == chunks.begin ())
+    return;
+  --it;
+  char *base = it->first;
+  chunk_t &c = it->second;
+
+  allocated -= len;
+  --c.live;
+
+  // the last block of a chunk can be reused right away
+  if (q + len == base + c.used)
+    c.used = q - base;
+
+  if (c.live == 0) {
+    if (c.current)
+      c.used = 0;
+    else
+      release (base, c);
+  }
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+
+#include <async_writer.h>
+#include <tracer.h>
+
+
+async_writer_t::async_writer_t (std::size_t max_pending_)
+  : max_pending (std::max (max_pending_, std::size_t (1))),
+    reserved (0), busy (false), stop (false) {
+  worker = std::thread (&async_writer_t::run, this);
+}
+
+
+async_writer_t::~async_writer_t () {
+  {
+    std::unique_lock<std::mutex> lock (mtx);
+    stop = true;
+  }
+  not_empty.notify_all ();
+  worker.join ();
+}
+
+
+void
+async_writer_t::submit (std::function<void ()> job) {
+  acquire_slot ();
+  push (std::move (job));
+}
+
+
+void
+async_writer_t::acquire_slot () {
+  std::unique_lock<std::mutex> lock (mtx);
+  not_full.wait (lock, [this] {
+    return queue.size () + reserved < max_pending;
+  });
+  ++reserved;
+}
+
+
+void
+async_writer_t::release_slot () {
+  {
+    std::unique_lock<std::mutex> lock (mtx);
+    --reserved;
+  }
+  not_full.notify_one ();
+  idle.notify_all ();
+}
+
+
+void
+async_writer_t::push (std::function<void ()> job) {
+  {
+    std::unique_lock<std::mutex> lock (mtx);
+    --reserved;
+    queue.push_back (std::move (job));
+  }
+  not_empty.notify_one ();
+}
+
+
+void
+async_writer_t::flush () {
+  std::unique_lock<std::mutex> lock (mtx);
+  idle.wait (lock, [this] {
+    return queue.empty () && reserved == 0 && ! busy;
+  });
+  if (error) {
+    std::exception_ptr e = error;
+    error = nullptr;
+    std::rethrow_exception (e);
+  }
+}
+
+
+std::size_t
+async_writer_t::pending () const {
+  std::unique_lock<std::mutex> lock (mtx);
+  return queue.size () + (busy ? 1 : 0);
+}
+
+
+void
+async_writer_t::run () {
+
+  for (;;) {
+
+    std::function<void ()> job;
+    {
+      std::unique_lock<std::mutex> lock (mtx);
+      not_empty.wait (lock, [this] { return stop || ! queue.empty (); });
+      if (queue.empty ())
+	return;
+      job = std::move (queue.front ());
+      queue.pop_front ();
+      busy = true;
+    }
+    not_full.notify_one ();
+
+    try {
+      QUADGRID_SPAN ("async_write", "io");
+      job ();
+    } catch (...) {
+      std::unique_lock<std::mutex> lock (mtx);
+      if (! error)
+	error = std::current_exception ();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock (mtx);
+      busy = false;
+    }
+    idle.notify_all ();
+  }
+}
+
+
+std::shared_ptr<const particles_t>
+async_writer_t::snapshot (const particles_t &p,
+			  const std::vector<std::string> &dpropnames,
+			  const std::vector<std::string> &ipropnames) {
+
+  // columns only, the binning index and the mass are not written
+  auto snap = std::make_shared<particles_t> (p.num_particles, p.grid);
+  snap->x = p.x;
+  snap->y = p.y;
+  if (dpropnames.empty () && ipropnames.empty ()) {
+    snap->dprops = p.dprops;
+    snap->iprops = p.iprops;
+    return snap;
+  }
+  for (auto const & ii : dpropnames)
+    snap->dprops.emplace (ii, p.dprops.at (ii));
+  for (auto const & ii : ipropnames)
+    snap->iprops.emplace (ii, p.iprops.at (ii));
+  return snap;
+}
@@ -0,0 +1,255 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <checkpoint.h>
+#include <particles.h>
+
+namespace {
+
+  constexpr char magic[8] = "QGCHKPT";
+  constexpr std::uint32_t byte_order_tag = 0x01020304;
+
+  std::uint64_t
+  align_up (std::uint64_t off) {
+    return (off + checkpoint_t::alignment - 1)
+      / checkpoint_t::alignment * checkpoint_t::alignment;
+  }
+
+  template <typename T>
+  checkpoint_t::entry_t
+  make_entry (const std::string &name, checkpoint_t::column_kind kind,
+	      std::uint64_t count) {
+    checkpoint_t::entry_t e;
+    std::memset (&e, 0, sizeof (e));
+    if (name.size () >= checkpoint_t::name_length)
+      throw std::runtime_error ("column name \"" + name
+				+ "\" too long for checkpoint");
+    std::strncpy (e.name, name.c_str (), checkpoint_t::name_length - 1);
+    e.kind = kind;
+    e.type = std::is_integral_v<T> ?
+      checkpoint_t::elem_type::integer : checkpoint_t::elem_type::floating;
+    e.elem_size = sizeof (T);
+    e.count = count;
+    return e;
+  }
+
+}
+
+
+void
+checkpoint_t::write (const char *filename, const particles_t &p,
+		     const std::map<std::string, std::vector<double>> &vars) {
+
+  QUADGRID_PHASE (p.stats, phase_t::checkpoint_write);
+  QUADGRID_COUNT (particles, p.x.size ());
+
+  using kind = column_kind;
+
+  // collect entries and pointers to the data to write
+  std::vector<entry_t> dir;
+  std::vector<const void *> src;
+
+  dir.push_back (make_entry<double> ("x", kind::x, p.x.size ()));
+  src.push_back (p.x.data ());
+  dir.push_back (make_entry<double> ("y", kind::y, p.y.size ()));
+  src.push_back (p.y.data ());
+
+  for (auto const & ii : p.dprops) {
+    dir.push_back (make_entry<double> (ii.first, kind::dprop,
+				       ii.second.size ()));
+    src.push_back (ii.second.data ());
+  }
+
+  for (auto const & ii : p.iprops) {
+    dir.push_back (make_entry<particles_t::idx_t> (ii.first, kind::iprop,
+						   ii.second.size ()));
+    src.push_back (ii.second.data ());
+  }
+
+  for (auto const & ii : vars) {
+    dir.push_back (make_entry<double> (ii.first, kind::grid_var,
+				       ii.second.size ()));
+    src.push_back (ii.second.data ());
+  }
+
+  // assign offsets
+  header_t h;
+  std::memset (&h, 0, sizeof (h));
+  std::memcpy (h.magic, magic, sizeof (magic));
+  h.version = version;
+  h.byte_order = byte_order_tag;
+  h.num_particles = p.num_particles;
+  h.numrows = p.grid.num_rows ();
+  h.numcols = p.grid.num_cols ();
+  h.hx = p.grid.hx ();
+  h.hy = p.grid.hy ();
+  h.num_columns = dir.size ();
+  h.directory_offset = sizeof (header_t);
+
+  std::uint64_t off = h.directory_offset + dir.size () * sizeof (entry_t);
+  for (auto & e : dir) {
+    e.offset = align_up (off);
+    off = e.offset + e.count * e.elem_size;
+  }
+  h.file_size = off;
+  QUADGRID_COUNT (bytes, h.file_size);
+
+  // write everything
+  std::ofstream ofs (filename, std::ofstream::out | std::ofstream::binary);
+  if (! ofs)
+    throw std::runtime_error (std::string ("cannot open checkpoint file ")
+			      + filename);
+
+  ofs.write (reinterpret_cast<const char *> (&h), sizeof (h));
+  ofs.write (reinterpret_cast<const char *> (dir.data ()),
+	     dir.size () * sizeof (entry_t));
+
+  static const char zeros[alignment] = {};
+  std::uint64_t pos = h.directory_offset + dir.size () * sizeof (entry_t);
+  for (std::size_t ii = 0; ii < dir.size (); ++ii) {
+    ofs.write (zeros, dir[ii].offset - pos);
+    ofs.write (static_cast<const char *> (src[ii]),
+	       dir[ii].count * dir[ii].elem_size);
+    pos = dir[ii].offset + dir[ii].count * dir[ii].elem_size;
+  }
+
+  ofs.close ();
+  if (! ofs)
+    throw std::runtime_error (std::string ("error writing checkpoint file ")
+			      + filename);
+}
+
+
+checkpoint_t::checkpoint_t (const char *filename)
+  : base (nullptr), length (0) {
+
+  int fd = ::open (filename, O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error (std::string ("cannot open checkpoint file ")
+			      + filename);
+
+  struct stat st;
+  if (::fstat (fd, &st) != 0 || st.st_size < (off_t) sizeof (header_t)) {
+    ::close (fd);
+    throw std::runtime_error (std::string ("invalid checkpoint file ")
+			      + filename);
+  }
+
+  length = st.st_size;
+  base = ::mmap (nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close (fd);
+  if (base == MAP_FAILED) {
+    base = nullptr;
+    throw std::runtime_error (std::string ("cannot map checkpoint file ")
+			      + filename);
+  }
+  ::madvise (base, length, MADV_SEQUENTIAL);
+  ::madvise (base, length, MADV_WILLNEED);
+
+  const header_t &h = header ();
+  std::string err;
+  if (std::memcmp (h.magic, magic, sizeof (magic)) != 0)
+    err = "not a checkpoint file ";
+  else if (h.version != version)
+    err = "unsupported checkpoint version in ";
+  else if (h.byte_order != byte_order_tag)
+    err = "checkpoint written with different byte order ";
+  else if (h.file_size != length || h.directory_offset > length
+	   || h.num_columns > (length - h.directory_offset) / sizeof (entry_t))
+    err = "truncated checkpoint file ";
+
+  if (err.empty ()) {
+    const entry_t *first = reinterpret_cast<const entry_t *>
+      (static_cast<const char *> (base) + h.directory_offset);
+    directory.assign (first, first + h.num_columns);
+    for (auto & e : directory) {
+      e.name[name_length - 1] = '\0';
+      // written sizes are 4 or 8 bytes, checked before the bounds
+      // so that they cannot divide by zero
+      if (e.kind > column_kind::grid_var || e.type > elem_type::integer
+	  || (e.elem_size != 4 && e.elem_size != 8)
+	  || e.offset % alignment != 0 || e.offset > length
+	  || e.count > (length - e.offset) / e.elem_size) {
+	err = "corrupt column directory in checkpoint file ";
+	break;
+      }
+    }
+  }
+
+  if (! err.empty ()) {
+    ::munmap (base, length);
+    base = nullptr;
+    throw std::runtime_error (err + filename);
+  }
+}
+
+
+checkpoint_t::~checkpoint_t () {
+  if (base != nullptr)
+    ::munmap (base, length);
+}
+
+
+const checkpoint_t::entry_t *
+checkpoint_t::find (column_kind kind, const std::string &name) const {
+  for (auto const & e : directory)
+    if (e.kind == kind
+	&& (kind == column_kind::x || kind == column_kind::y
+	    || name == e.name))
+      return &e;
+  return nullptr;
+}
+
+
+const checkpoint_t::entry_t &
+checkpoint_t::at (column_kind kind, const std::string &name) const {
+  const entry_t *e = find (kind, name);
+  if (e == nullptr)
+    throw std::out_of_range ("no column \"" + name + "\" in checkpoint");
+  return *e;
+}
+
+
+std::map<std::string, std::vector<double>>
+checkpoint_t::grid_vars () const {
+  std::map<std::string, std::vector<double>> vars;
+  for (auto const & e : directory)
+    if (e.kind == column_kind::grid_var)
+      copy (e.kind, e.name, vars[e.name]);
+  return vars;
+}
+
+
+particles_t::particles_t (const checkpoint_t &ckpt,
+			  const quadgrid_t<std::vector<double>>& grid_,
+			  std::pmr::memory_resource *mr)
+  : particles_t (static_cast<idx_t> (ckpt.num_particles ()), grid_, mr) {
+
+  using kind = checkpoint_t::column_kind;
+
+  for (auto const & e : ckpt.columns ())
+    if (e.kind != kind::grid_var && e.count != ckpt.num_particles ())
+      throw std::runtime_error (std::string ("checkpoint column \"")
+				+ e.name + "\" has "
+				+ std::to_string (e.count) + " entries for "
+				+ std::to_string (ckpt.num_particles ())
+				+ " particles");
+
+  ckpt.copy (kind::x, "x", x);
+  ckpt.copy (kind::y, "y", y);
+
+  for (auto const & e : ckpt.columns ()) {
+    if (e.kind == kind::dprop)
+      ckpt.copy (e.kind, e.name, dprops[e.name]);
+    else if (e.kind == kind::iprop)
+      ckpt.copy (e.kind, e.name, iprops[e.name]);
+  }
+
+  init_particle_mesh ();
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include <field_registry.h>
+#include <numa_placement.h>
+
+
+field_registry_t::field_registry_t (const quadgrid_t<std::vector<double>> &grid_,
+				    std::pmr::memory_resource *upstream)
+  : grid (grid_), nnodes (grid_.num_global_nodes ()),
+    arena (std::size_t (16) << 20, arena_resource_t::default_alignment,
+	   false, upstream) { }
+
+
+field_registry_t::handle_t
+field_registry_t::add (const std::string &name, int components) {
+
+  auto it = index.find (name);
+  if (it != index.end ()) {
+    if (fields[it->second].components != components)
+      throw std::invalid_argument ("grid field \"" + name + "\" exists with "
+				   + std::to_string (fields[it->second].components)
+				   + " components");
+    return handle_t {it->second};
+  }
+  if (components < 1)
+    throw std::invalid_argument ("grid fields need at least one component");
+
+  const std::size_t n = static_cast<std::size_t> (nnodes) * components;
+  entry_t e {name, components, field_t (&arena), false, false, {}};
+  e.values.reserve (n);
+  NUMA_PLACEMENT::first_touch (e.values.data (), n * sizeof (double));
+  e.values.assign (n, 0.);
+
+  fields.push_back (std::move (e));
+  index[name] = fields.size () - 1;
+  return handle_t {fields.size () - 1};
+}
+
+
+field_registry_t::handle_t
+field_registry_t::handle (const std::string &name) const {
+  auto it = index.find (name);
+  if (it == index.end ())
+    throw std::out_of_range ("no grid field named \"" + name + "\"");
+  return handle_t {it->second};
+}
+
+
+void
+field_registry_t::zero (std::initializer_list<handle_t> hs) {
+  for (auto h : hs)
+    fields.at (h.id).pending = true;
+}
+
+
+void
+field_registry_t::zero_all () {
+  for (auto & e : fields)
+    e.pending = true;
+}
+
+
+field_registry_t::field_t &
+field_registry_t::operator[] (handle_t h) {
+  auto & e = fields.at (h.id);
+  flush (e);
+  e.all_dirty = true;
+  return e.values;
+}
+
+
+const field_registry_t::field_t &
+field_registry_t::operator[] (handle_t h) const {
+  return values (h);
+}
+
+
+const field_registry_t::field_t &
+field_registry_t::values (handle_t h) const {
+  auto & e = fields.at (h.id);
+  flush (e);
+  return e.values;
+}
+
+
+void
+field_registry_t::copy_to (std::map<std::string, std::vector<double>> &vars) const {
+  for (auto & e : fields) {
+    flush (e);
+    if (e.components == 1) {
+      vars[e.name].assign (e.values.begin (), e.values.end ());
+      continue;
+    }
+    for (int k = 0; k < e.components; ++k) {
+      auto & v = vars[e.name + "_" + std::to_string (k)];
+      v.resize (nnodes);
+      for (idx_t ii = 0; ii < nnodes; ++ii)
+	v[ii] = e.values[std::size_t (ii) * e.components + k];
+    }
+  }
+}
+
+
+double *
+field_registry_t::begin_scatter (handle_t h, bool &fused) {
+
+  auto & e = fields.at (h.id);
+  fused = e.pending && ! e.all_dirty;
+  if (! fused)
+    flush (e);
+  else
+    hits.assign ((static_cast<std::size_t> (nnodes) + 63) / 64, 0);
+  return e.values.data ();
+}
+
+
+void
+field_registry_t::end_scatter (handle_t h, const std::vector<idx_t> &cells) {
+
+  auto & e = fields.at (h.id);
+  if (e.pending) {
+    // nodes written before the zeroing and not hit since
+    clear_cells (e, e.dirty, true);
+    e.pending = false;
+    e.dirty = cells;
+    return;
+  }
+
+  std::vector<idx_t> merged;
+  merged.reserve (e.dirty.size () + cells.size ());
+  std::set_union (e.dirty.begin (), e.dirty.end (),
+		  cells.begin (), cells.end (),
+		  std::back_inserter (merged));
+  e.dirty.swap (merged);
+}
+
+
+void
+field_registry_t::flush (entry_t &e) const {
+
+  if (! e.pending)
+    return;
+
+  if (e.all_dirty)
+    std::fill (e.values.begin (), e.values.end (), 0.);
+  else
+    clear_cells (e, e.dirty, false);
+
+  e.pending = false;
+  e.all_dirty = false;
+  e.dirty.clear ();
+}
+
+
+void
+field_registry_t::clear_cells (entry_t &e, const std::vector<idx_t> &cells,
+			       bool skip_hits) const {
+  for (auto gidx : cells) {
+    auto const icell = grid.cell (gidx);
+    for (idx_t inode = 0; inode < 4; ++inode) {
+      const idx_t n = icell.gt (inode);
+      if (! skip_hits || (hits[n >> 6] & (std::uint64_t (1) << (n & 63))) == 0)
+	std::fill_n (e.values.begin () + std::size_t (n) * e.components,
+		     e.components, 0.);
+    }
+  }
+}
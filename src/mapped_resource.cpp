@@ -0,0 +1,129 @@
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <mapped_resource.h>
+
+namespace {
+
+  int
+  madvise_flag (mapped_resource_t::advice_t a) {
+    switch (a) {
+    case mapped_resource_t::advice_t::sequential :
+      return MADV_SEQUENTIAL;
+    case mapped_resource_t::advice_t::random :
+      return MADV_RANDOM;
+    case mapped_resource_t::advice_t::willneed :
+      return MADV_WILLNEED;
+    case mapped_resource_t::advice_t::dontneed :
+      return MADV_DONTNEED;
+    default :
+      return MADV_NORMAL;
+    }
+  }
+
+  std::size_t
+  page_size () {
+    static const std::size_t ps = static_cast<std::size_t> (::sysconf (_SC_PAGESIZE));
+    return ps;
+  }
+
+}
+
+
+mapped_resource_t::mapped_resource_t (const std::string &directory_,
+				      std::size_t min_bytes_,
+				      advice_t advice_,
+				      std::pmr::memory_resource *upstream_)
+  : directory (directory_), min_bytes (min_bytes_), advice (advice_),
+    upstream (upstream_) { }
+
+
+mapped_resource_t::~mapped_resource_t () {
+  for (auto const & ii : mappings)
+    ::munmap (ii.first, ii.second);
+}
+
+
+void
+mapped_resource_t::advise (const void *p, std::size_t bytes, advice_t a) {
+  if (p == nullptr || bytes == 0)
+    return;
+  // madvise wants a page aligned start
+  const std::size_t ps = page_size ();
+  const auto addr = reinterpret_cast<std::uintptr_t> (p);
+  const auto start = addr & ~(ps - 1);
+  ::madvise (reinterpret_cast<void *> (start), bytes + (addr - start),
+	     madvise_flag (a));
+}
+
+
+std::size_t
+mapped_resource_t::bytes_mapped () const {
+  std::lock_guard<std::mutex> lock (mtx);
+  return mapped;
+}
+
+
+std::size_t
+mapped_resource_t::num_mappings () const {
+  std::lock_guard<std::mutex> lock (mtx);
+  return mappings.size ();
+}
+
+
+void *
+mapped_resource_t::do_allocate (std::size_t bytes, std::size_t alignment) {
+
+  if (bytes < min_bytes || alignment > page_size ())
+    return upstream->allocate (bytes, alignment);
+
+  const std::size_t len = (bytes + page_size () - 1) & ~(page_size () - 1);
+
+  std::string name = directory + "/quadgrid_columns_XXXXXX";
+  std::vector<char> tmpl (name.begin (), name.end ());
+  tmpl.push_back ('\0');
+  const int fd = ::mkstemp (tmpl.data ());
+  if (fd < 0)
+    throw std::bad_alloc ();
+
+  // the file lives as long as it is mapped
+  ::unlink (tmpl.data ());
+  if (::ftruncate (fd, static_cast<off_t> (len)) != 0) {
+    ::close (fd);
+    throw std::bad_alloc ();
+  }
+
+  void *p = ::mmap (nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close (fd);
+  if (p == MAP_FAILED)
+    throw std::bad_alloc ();
+  ::madvise (p, len, madvise_flag (advice));
+
+  std::lock_guard<std::mutex> lock (mtx);
+  mappings[p] = len;
+  mapped += len;
+  return p;
+}
+
+
+void
+mapped_resource_t::do_deallocate (void *p, std::size_t bytes,
+				  std::size_t alignment) {
+  {
+    std::lock_guard<std::mutex> lock (mtx);
+    auto it = mappings.find (p);
+    if (it != mappings.end ()) {
+      ::munmap (p, it->second);
+      mapped -= it->second;
+      mappings.erase (it);
+      return;
+    }
+  }
+  upstream->deallocate (p, bytes, alignment);
+}
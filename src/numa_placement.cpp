@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#include <mpi.h>
+#include <sched.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <numa_placement.h>
+
+namespace {
+
+  std::size_t
+  page_size () {
+    static const std::size_t ps = static_cast<std::size_t> (::sysconf (_SC_PAGESIZE));
+    return ps;
+  }
+
+  int
+  package_of (int cpu) {
+    std::ifstream is ("/sys/devices/system/cpu/cpu" + std::to_string (cpu)
+		      + "/topology/physical_package_id");
+    int id = 0;
+    if (! (is >> id))
+      id = 0;
+    return id;
+  }
+
+  // position among the ranks of the node which may run on exactly
+  // the same cores, 0 without MPI or if the launcher gave each rank
+  // cores of its own
+  int
+  node_local_offset (const cpu_set_t &allowed) {
+
+    int initialized = 0, finalized = 0;
+    MPI_Initialized (&initialized);
+    MPI_Finalized (&finalized);
+    if (! initialized || finalized)
+      return 0;
+
+    MPI_Comm node;
+    MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+			 MPI_INFO_NULL, &node);
+    int rank = 0;
+    MPI_Comm_rank (node, &rank);
+
+    std::vector<unsigned char> mine (CPU_SETSIZE / 8, 0), all (mine.size ()),
+      any (mine.size ());
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      if (CPU_ISSET (cpu, &allowed))
+	mine[cpu / 8] |= static_cast<unsigned char> (1 << (cpu % 8));
+    MPI_Allreduce (mine.data (), all.data (), mine.size (),
+		   MPI_UNSIGNED_CHAR, MPI_BAND, node);
+    MPI_Allreduce (mine.data (), any.data (), mine.size (),
+		   MPI_UNSIGNED_CHAR, MPI_BOR, node);
+    MPI_Comm_free (&node);
+
+    return all == any ? rank : 0;
+  }
+
+}
+
+
+void
+NUMA_PLACEMENT::first_touch (void *p, std::size_t bytes) {
+
+  if (p == nullptr || bytes == 0)
+    return;
+
+  // start from the first page boundary, the partial page before
+  // it belongs to whoever touched it first
+  const std::size_t ps = page_size ();
+  const auto addr = reinterpret_cast<std::uintptr_t> (p);
+  const auto first = (addr + ps - 1) & ~(ps - 1);
+  const auto last = addr + bytes;
+  if (first >= last)
+    return;
+  const std::int64_t npages = (last - first + ps - 1) / ps;
+  volatile char *base = reinterpret_cast<char *> (first);
+
+#pragma omp parallel for schedule(static)
+  for (std::int64_t ii = 0; ii < npages; ++ii)
+    base[ii * ps] = 0;
+}
+
+
+NUMA_PLACEMENT::affinity_t
+NUMA_PLACEMENT::affinity_from_string (const std::string &name) {
+  if (name == "none")
+    return affinity_t::none;
+  else if (name == "compact")
+    return affinity_t::compact;
+  else if (name == "scatter")
+    return affinity_t::scatter;
+  throw std::invalid_argument ("unknown thread affinity \"" + name + "\"");
+}
+
+
+std::vector<int>
+NUMA_PLACEMENT::pin_threads (affinity_t a) {
+
+  std::vector<int> placement;
+  if (a == affinity_t::none)
+    return placement;
+
+  cpu_set_t allowed;
+  CPU_ZERO (&allowed);
+  if (::sched_getaffinity (0, sizeof (allowed), &allowed) != 0)
+    return placement;
+
+  // allowed cores, grouped by socket
+  std::map<int, std::vector<int>> sockets;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET (cpu, &allowed))
+      sockets[package_of (cpu)].push_back (cpu);
+
+  std::vector<int> cores;
+  if (a == affinity_t::compact)
+    for (auto const & ii : sockets)
+      cores.insert (cores.end (), ii.second.begin (), ii.second.end ());
+  else
+    for (std::size_t jj = 0; cores.size () < static_cast<std::size_t> (CPU_COUNT (&allowed)); ++jj)
+      for (auto const & ii : sockets)
+	if (jj < ii.second.size ())
+	  cores.push_back (ii.second[jj]);
+  if (cores.empty ())
+    return placement;
+
+  int nthreads = 1;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads ();
+#endif
+  placement.assign (nthreads, -1);
+
+  // ranks sharing the cores take consecutive blocks of them
+  const std::size_t offset
+    = static_cast<std::size_t> (node_local_offset (allowed)) * nthreads;
+
+#pragma omp parallel num_threads(nthreads)
+  {
+    int tid = 0;
+#ifdef _OPENMP
+    tid = omp_get_thread_num ();
+#endif
+    const int cpu = cores[(offset + tid) % cores.size ()];
+    cpu_set_t mask;
+    CPU_ZERO (&mask);
+    CPU_SET (cpu, &mask);
+    if (::sched_setaffinity (0, sizeof (mask), &mask) == 0)
+      placement[tid] = cpu;
+  }
+
+  return placement;
+}
@@ -1,41 +1,81 @@
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
-#include <random>
+#include <limits>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <ascii_format.h>
+#include <content_hash.h>
+#include <numa_placement.h>
 #include <particles.h>
 
+namespace {
+
+  // nearest value to `v` in cell `i` of size `h` along one axis, as
+  // located by particles_t::cell_index: `v` is computed inside the
+  // cell, but rounding may put it on the upper edge, which belongs
+  // to the next cell
+  double
+  into_cell (double v, double h, std::int64_t i) {
+    const double inf = std::numeric_limits<double>::infinity ();
+    while (std::floor (v / h) > i)
+      v = std::nextafter (v, -inf);
+    while (std::floor (v / h) < i)
+      v = std::nextafter (v, inf);
+    return v;
+  }
+
+  // each component of the fields `gvars` needs a property
+  void
+  check_components (const field_registry_t & fields,
+		    std::vector<field_registry_t::handle_t> const & gvars,
+		    std::vector<std::string> const & pvarnames) {
+    std::size_t total = 0;
+    for (auto h : gvars)
+      total += fields.components (h);
+    if (total != pvarnames.size ())
+      throw std::invalid_argument ("fields have " + std::to_string (total)
+				   + " components in all, but "
+				   + std::to_string (pvarnames.size ())
+				   + " particle properties are given");
+  }
+
+}
+
 
 double
 particles_t::default_x_generator () {
-  static std::random_device rd;
-  static std::mt19937 gen (rd ());
-  static std::uniform_real_distribution<> dis (0.0, 1.0);
-  return dis (gen) * grid.num_cols () * grid.hx ();
+  return philox_t (default_seed).uniform2 (x_draws++)[0]
+    * grid.num_cols () * grid.hx ();
 }
 
 double
 particles_t::default_y_generator () {
-  static std::random_device rd;
-  static std::mt19937 gen (rd ());
-  static std::uniform_real_distribution<> dis (0.0, 1.0);
-  return dis (gen) * grid.num_rows () * grid.hy ();
+  return philox_t (default_seed).uniform2 (y_draws++)[1]
+    * grid.num_rows () * grid.hy ();
 }
 
+particle_columns_t::particle_columns_t (const particle_columns_t &other)
+  : resource (std::pmr::get_default_resource ()),
+    x (other.x, resource), y (other.y, resource),
+    iprops (other.iprops, resource), dprops (other.dprops, resource) { }
+
+
 particles_t::particles_t
 (
  idx_t n, const std::vector<std::string>& ipropnames,
  const std::vector<std::string>& dpropnames,
- const quadgrid_t<std::vector<double>>& grid_
- ) :  particles_t (n, grid_) {
+ const quadgrid_t<std::vector<double>>& grid_,
+ std::pmr::memory_resource *mr
+ ) :  particles_t (n, grid_, mr) {
   
   init_props (ipropnames, dpropnames);
 
-  init_particle_positions
-    (
-     [this] { return this->default_x_generator (); },
-     [this] { return this->default_y_generator (); }
-     );
+  init_particle_positions (default_seed);
 
     init_particle_mesh ();
 }
@@ -47,11 +87,12 @@ particles_t::particles_t
  const std::vector<std::string>& dpropnames,
  const quadgrid_t<std::vector<double>>& grid_,
  const std::vector<double> & xgen,
- const std::vector<double> & ygen
- ) : particles_t (n, grid_) {
+ const std::vector<double> & ygen,
+ std::pmr::memory_resource *mr
+ ) : particles_t (n, grid_, mr) {
 
-    x = xgen;
-    y = ygen;
+    x.assign (xgen.begin (), xgen.end ());
+    y.assign (ygen.begin (), ygen.end ());
 
     init_props (ipropnames, dpropnames);
 
@@ -64,8 +105,9 @@ particles_t::particles_t
  const std::vector<std::string>& dpropnames,
  const quadgrid_t<std::vector<double>>& grid_,
  std::function<double ()> xgen,
- std::function<double ()> ygen
- ) : particles_t (n, grid_) {
+ std::function<double ()> ygen,
+ std::pmr::memory_resource *mr
+ ) : particles_t (n, grid_, mr) {
   
   init_props (ipropnames, dpropnames);
   
@@ -82,28 +124,274 @@ particles_t::init_props
  const std::vector<std::string>& dpropnames
  ) {
 
-  for (idx_t ii = 0; ii < ipropnames.size (); ++ii) {
+  for (auto const & ii : ipropnames)
+    iprops[ii];
+  for (auto const & ii : dpropnames)
+    dprops[ii];
+  reserve (num_particles);
+
+  for (std::size_t ii = 0; ii < ipropnames.size (); ++ii) {
     iprops[ipropnames[ii]].assign (num_particles, 0);
   }
   
-  for (idx_t ii = 0; ii < dpropnames.size (); ++ii) {
+  for (std::size_t ii = 0; ii < dpropnames.size (); ++ii) {
     dprops[dpropnames[ii]].assign (num_particles, 0.0);
   } 
 }
 
 
+void
+particles_t::reserve (idx_t n) {
+
+  auto capacity = [n] (std::size_t size) {
+    const std::size_t per_block = column_padding / size;
+    return (static_cast<std::size_t> (n) + per_block - 1) / per_block * per_block;
+  };
+  const std::size_t dcap = capacity (sizeof (double));
+  const std::size_t icap = capacity (sizeof (idx_t));
+
+  bool grow = x.capacity () < dcap || y.capacity () < dcap;
+  for (auto const & ii : dprops)
+    grow = grow || ii.second.capacity () < dcap;
+  for (auto const & ii : iprops)
+    grow = grow || ii.second.capacity () < icap;
+  if (! grow)
+    return;
+
+  auto regrow = [this] (auto const & col, std::size_t cap) {
+    std::decay_t<decltype (col)> c (resource);
+    c.reserve (std::max (cap, col.size ()));
+    NUMA_PLACEMENT::first_touch (c.data (), c.capacity () * sizeof (c[0]));
+    c.assign (col.begin (), col.end ());
+    return c;
+  };
+
+  // allocate all new columns first, then release the old ones
+  dcolumn_t xn = regrow (x, dcap), yn = regrow (y, dcap);
+  std::vector<dcolumn_t> dn;
+  std::vector<icolumn_t> in;
+  dn.reserve (dprops.size ());
+  in.reserve (iprops.size ());
+  for (auto const & ii : dprops)
+    dn.push_back (regrow (ii.second, dcap));
+  for (auto const & ii : iprops)
+    in.push_back (regrow (ii.second, icap));
+
+  x.swap (xn);
+  y.swap (yn);
+  auto dd = dn.begin ();
+  for (auto & ii : dprops)
+    ii.second.swap (*dd++);
+  auto jj = in.begin ();
+  for (auto & ii : iprops)
+    ii.second.swap (*jj++);
+}
+
+
 void
 particles_t::init_particle_mesh () {
+
+  QUADGRID_PHASE (stats, phase_t::init_particle_mesh);
+  QUADGRID_COUNT (particles, x.size ());
   
+  if (x.size () > static_cast<std::size_t> (std::numeric_limits<bin_idx_t>::max ()))
+    throw std::overflow_error ("too many particles for the binning index type");
+
   for (auto & igrd : grd_to_ptcl)
-    std::vector<idx_t>{}. swap (igrd.second);
-  
-  for (auto ii = 0; ii < x.size (); ++ii) {
-    idx_t c = static_cast<idx_t> (std::floor (x[ii] / grid.hx ()));
-    idx_t r = static_cast<idx_t> (std::floor (y[ii] / grid.hy ()));
+    std::vector<bin_idx_t>{}. swap (igrd.second);
+
+  // locate particles with the same partition as the particle loops
+  const std::int64_t n = x.size ();
+  std::vector<idx_t> cells (n);
+#pragma omp parallel for schedule(static)
+  for (std::int64_t ii = 0; ii < n; ++ii)
+    cells[ii] = cell_index (x[ii], y[ii]);
+
+  // particles outside the grid are binned under quadgrid_t::out_of_grid;
+  // on a grid with many more cells than particles, sort (cell, particle)
+  // pairs rather than counting over every cell, so that binning does not
+  // cost O(number of cells). Either way lists are sized once and filled
+  // in particle order; they are mostly smaller than a page, so they are
+  // not placed by first touch
+  const idx_t num_cells = grid.num_global_cells ();
+  if (num_cells <= 4 * n) {
+    std::vector<idx_t> counts (num_cells, 0);
+    std::map<idx_t, idx_t> outside;
+    for (auto icell : cells)
+      if (icell >= 0 && icell < num_cells)
+	++counts[icell];
+      else
+	++outside[icell];
+
+    for (idx_t icell = 0; icell < num_cells; ++icell)
+      if (counts[icell] > 0)
+	grd_to_ptcl[icell].reserve (counts[icell]);
+    for (auto const & ii : outside)
+      grd_to_ptcl[ii.first].reserve (ii.second);
+
+    for (std::int64_t ii = 0; ii < n; ++ii)
+      grd_to_ptcl[cells[ii]].push_back (static_cast<bin_idx_t> (ii));
+  }
+  else {
+    std::vector<std::pair<idx_t, bin_idx_t>> order (n);
+    for (std::int64_t ii = 0; ii < n; ++ii)
+      order[ii] = {cells[ii], static_cast<bin_idx_t> (ii)};
+    std::sort (order.begin (), order.end ());
+
+    for (std::int64_t first = 0, last = 0; first < n; first = last) {
+      while (last < n && order[last].first == order[first].first)
+	++last;
+      auto & plist = grd_to_ptcl[order[first].first];
+      plist.reserve (last - first);
+      for (auto ii = first; ii < last; ++ii)
+	plist.push_back (order[ii].second);
+    }
+  }
 
-    grd_to_ptcl[grid.sub2gind (r, c)].push_back (ii);
+  update_active_cells ();
+  ++binning_version;
+}
+
+
+void
+particles_t::update_active_cells () {
+  // particles outside the grid stay binned, but their cells have
+  // no nodes to transfer to
+  const idx_t num_cells = grid.num_global_cells ();
+  active_cells.clear ();
+  for (auto const & igrd : grd_to_ptcl)
+    if (! igrd.second.empty () && igrd.first >= 0 && igrd.first < num_cells)
+      active_cells.push_back (igrd.first);
+
+  // nodes shared by active cells are listed once: with a mask over
+  // the nodes if most cells are active, by sorting otherwise
+  const idx_t num_nodes = grid.num_global_nodes ();
+  active_nodes.clear ();
+  if (4 * active_cells.size () >= static_cast<std::size_t> (num_nodes)) {
+    std::vector<char> mask (num_nodes, 0);
+    for (auto gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      for (idx_t inode = 0; inode < 4; ++inode)
+	mask[icell.gt (inode)] = 1;
+    }
+    for (idx_t n = 0; n < num_nodes; ++n)
+      if (mask[n])
+	active_nodes.push_back (n);
+  }
+  else {
+    active_nodes.reserve (4 * active_cells.size ());
+    for (auto gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      for (idx_t inode = 0; inode < 4; ++inode)
+	active_nodes.push_back (icell.gt (inode));
+    }
+    std::sort (active_nodes.begin (), active_nodes.end ());
+    active_nodes.erase (std::unique (active_nodes.begin (), active_nodes.end ()),
+			active_nodes.end ());
+  }
+}
+
+
+memory_report_t
+particles_t::memory_report () const {
+
+  memory_report_t r;
+  r.add ("object", "particles_t", sizeof (particles_t), sizeof (particles_t));
+
+  r.add_vector ("positions", "x", x);
+  r.add_vector ("positions", "y", y);
+
+  for (auto const & ii : dprops)
+    r.add_vector ("dprops", ii.first, ii.second);
+  const auto dkeys = memory_report_t::column_map_bytes (dprops);
+  r.add ("dprops", "(map nodes and keys)", dkeys, dkeys);
+
+  for (auto const & ii : iprops)
+    r.add_vector ("iprops", ii.first, ii.second);
+  const auto ikeys = memory_report_t::column_map_bytes (iprops);
+  r.add ("iprops", "(map nodes and keys)", ikeys, ikeys);
+
+  // cells emptied by init_particle_mesh keep their (empty) node
+  const auto nodes = grd_to_ptcl.size ()
+    * memory_report_t::map_node_bytes<idx_t, std::vector<bin_idx_t>> ();
+  r.add ("binning", "grd_to_ptcl map nodes", nodes, nodes);
+  std::size_t used = 0, reserved = 0;
+  for (auto const & ii : grd_to_ptcl) {
+    used += ii.second.size () * sizeof (bin_idx_t);
+    reserved += ii.second.capacity () * sizeof (bin_idx_t);
+  }
+  r.add ("binning", "grd_to_ptcl cell lists", used, reserved);
+  r.add_vector ("binning", "active_cells", active_cells);
+  r.add_vector ("binning", "active_nodes", active_nodes);
+
+  r.add_vector ("mass", "M", M);
+  r.add_vector ("mass", "Minv", Minv);
+
+  return r;
+}
+
+
+density_diagnostics_t
+particles_t::density_diagnostics (idx_t num_parts, bool collective) const {
+
+  if (num_parts <= 0) {
+    num_parts = 1;
+#ifdef _OPENMP
+    num_parts = omp_get_max_threads ();
+#endif
+  }
+
+  density_diagnostics_t d;
+  d.num_cells = grid.num_global_cells ();
+  d.counts.assign (d.num_cells, 0.);
+  d.histogram.assign (1, 0);
+  d.part_load.assign (num_parts, 0);
+
+  // cells not in the active list are empty
+  const std::int64_t num_active = active_cells.size ();
+  d.histogram[0] = d.num_cells - num_active;
+  d.min_count = num_active < d.num_cells ? 0
+    : std::numeric_limits<std::int64_t>::max ();
+  for (auto const & icell : active_cells) {
+    const std::int64_t n = grd_to_ptcl.at (icell).size ();
+    d.counts[icell] = n;
+    d.num_particles += n;
+    d.min_count = std::min (d.min_count, n);
+    d.max_count = std::max (d.max_count, n);
+    std::size_t bin = 0;
+    for (auto m = n; m > 0; m >>= 1)
+      ++bin;
+    if (bin >= d.histogram.size ())
+      d.histogram.resize (bin + 1, 0);
+    ++d.histogram[bin];
+    d.part_load[icell * static_cast<std::int64_t> (num_parts) / d.num_cells] += n;
+  }
+  if (d.num_cells == 0)
+    d.min_count = 0;
+
+  if (d.num_cells > 0) {
+    d.mean_count = static_cast<double> (d.num_particles) / d.num_cells;
+    d.empty_fraction = static_cast<double> (d.histogram[0]) / d.num_cells;
+  }
+  if (d.num_particles > 0)
+    d.imbalance = *std::max_element (d.part_load.begin (), d.part_load.end ())
+      * static_cast<double> (num_parts) / d.num_particles;
+
+  if (collective) {
+    int flag = 0;
+    MPI_Initialized (&flag);
+    if (flag) {
+      int nranks = 1;
+      MPI_Comm_size (grid.comm, &nranks);
+      double local = d.num_particles, max = 0., sum = 0.;
+      MPI_Allreduce (&local, &max, 1, MPI_DOUBLE, MPI_MAX, grid.comm);
+      MPI_Allreduce (&local, &sum, 1, MPI_DOUBLE, MPI_SUM, grid.comm);
+      if (sum > 0.)
+	d.rank_imbalance = max * nranks / sum;
+    }
   }
+
+  return d;
 }
 
 
@@ -121,16 +409,300 @@ particles_t::init_particle_positions
 }
 
 
+void
+particles_t::init_particle_positions (std::uint64_t seed,
+				      std::uint64_t first_index) {
+
+  x.resize (num_particles);
+  y.resize (num_particles);
+
+  const philox_t rng (seed);
+  const double lx = grid.num_cols () * grid.hx ();
+  const double ly = grid.num_rows () * grid.hy ();
+  const std::int64_t n = num_particles;
+
+#pragma omp parallel for schedule(static)
+  for (std::int64_t ii = 0; ii < n; ++ii) {
+    const auto u = rng.uniform2 (first_index + ii);
+    x[ii] = u[0] * lx;
+    y[ii] = u[1] * ly;
+  }
+}
+
+
+
+void
+particles_t::seed_cells (idx_t nx, idx_t ny, seeding_t mode,
+			 std::function<bool (double, double)> inside,
+			 std::uint64_t seed) {
+
+  if (nx <= 0 || ny <= 0)
+    throw std::invalid_argument ("seed_cells needs at least one particle "
+				 "per cell in each direction, got "
+				 + std::to_string (nx) + " x "
+				 + std::to_string (ny));
+
+  QUADGRID_PHASE (stats, phase_t::init_particle_mesh);
+
+  const idx_t num_cells = grid.num_global_cells ();
+  const idx_t per_cell = QUADGRID_CONFIG::checked_product<idx_t> (nx, ny, "particles per cell");
+  const double dx = grid.hx () / nx, dy = grid.hy () / ny;
+  const philox_t rng (seed);
+
+  x.clear ();
+  y.clear ();
+  grd_to_ptcl.clear ();
+  for (auto & ii : dprops)
+    ii.second.clear ();
+  for (auto & ii : iprops)
+    ii.second.clear ();
+  if (! inside)
+    reserve (QUADGRID_CONFIG::checked_product<idx_t> (num_cells, per_cell, "number of particles"));
+
+  std::vector<bin_idx_t> plist;
+  for (idx_t gidx = 0; gidx < num_cells; ++gidx) {
+    auto const icell = grid.cell (gidx);
+    const double x0 = icell.p (0, 0), y0 = icell.p (1, 0);
+    const std::int64_t col = grid.gind2col (gidx), row = grid.gind2row (gidx);
+    for (idx_t k = 0; k < per_cell; ++k) {
+      double u = .5, v = .5;
+      if (mode == seeding_t::jittered) {
+	const auto r = rng.uniform2 (gidx, k);
+	u = r[0];
+	v = r[1];
+      }
+      const double xx = into_cell (x0 + (k % nx + u) * dx, grid.hx (), col);
+      const double yy = into_cell (y0 + (k / nx + v) * dy, grid.hy (), row);
+      if (inside && ! inside (xx, yy))
+	continue;
+      if (x.size () >= static_cast<std::size_t> (std::numeric_limits<bin_idx_t>::max ()))
+	throw std::overflow_error ("too many particles for the binning index type");
+      plist.push_back (static_cast<bin_idx_t> (x.size ()));
+      x.push_back (xx);
+      y.push_back (yy);
+    }
+    // cells come in increasing order, insert at the end of the map
+    if (! plist.empty ()) {
+      grd_to_ptcl.emplace_hint (grd_to_ptcl.end (), gidx, std::move (plist));
+      plist.clear ();
+    }
+  }
+  update_active_cells ();
+
+  num_particles = static_cast<idx_t> (x.size ());
+  ++binning_version;
+  for (auto & ii : dprops)
+    ii.second.assign (num_particles, 0.);
+  for (auto & ii : iprops)
+    ii.second.assign (num_particles, 0);
+  QUADGRID_COUNT (particles, x.size ());
+}
+
 
 void
 particles_t::build_mass () {
+  QUADGRID_PHASE (stats, phase_t::build_mass);
+  auto const & lumped = grid.lumped_mass ();
+  NUMA_PLACEMENT::first_touch_reserve (M, lumped.size ());
+  M.assign (lumped.begin (), lumped.end ());
+  update_inverse_mass ();
+}
+
+
+void
+particles_t::build_particle_mass (const std::string & mass) {
+
+  auto const & mp = dprops.at (mass);
+  std::uint64_t h = CONTENT_HASH::offset_basis;
+  h = CONTENT_HASH::hash_vector (x, h);
+  h = CONTENT_HASH::hash_vector (y, h);
+  h = CONTENT_HASH::hash_vector (mp, h);
+
+  if (mass_prop == mass && mass_version == binning_version
+      && mass_hash == h
+      && M.size () == static_cast<std::size_t> (grid.num_global_nodes ()))
+    return;
+
+  QUADGRID_PHASE (stats, phase_t::build_mass);
+  QUADGRID_COUNT (particles, x.size ());
+  QUADGRID_COUNT (cells, active_cells.size ());
+
+  // active cells by grid column
+  const idx_t num_cells = grid.num_global_cells ();
+  const std::int64_t num_cols = grid.num_cols ();
+  std::vector<std::vector<idx_t>> columns (num_cols);
+  for (auto gidx : active_cells)
+    if (gidx >= 0 && gidx < num_cells)
+      columns[grid.gind2col (gidx)].push_back (gidx);
+
+  NUMA_PLACEMENT::first_touch_reserve (M, grid.num_global_nodes ());
   M.assign (grid.num_global_nodes (), 0.0);
-  for (auto icell = grid.begin_cell_sweep ();
-       icell != grid.end_cell_sweep (); ++icell) {
-    for (auto inode = 0;
-	 inode < quadgrid_t<std::vector<double>>::cell_t::nodes_per_cell;
-	 ++inode) {
-      M[icell->gt (inode)] += (grid.hx () / 2.) * (grid.hy () / 2.);
+
+  for (std::int64_t parity = 0; parity < 2; ++parity) {
+#pragma omp parallel for schedule(dynamic)
+    for (std::int64_t ic = parity; ic < num_cols; ic += 2)
+      for (auto gidx : columns[ic]) {
+	auto const icell = grid.cell (gidx);
+	auto const & plist = grd_to_ptcl.at (gidx);
+	for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+	  const idx_t idx = plist[ii];
+	  for (idx_t inode = 0; inode < 4; ++inode)
+	    M[icell.gt (inode)] += icell.shp (x[idx], y[idx], inode) * mp[idx];
+	}
+      }
+  }
+
+  update_inverse_mass ();
+  mass_prop = mass;
+  mass_version = binning_version;
+  mass_hash = h;
+}
+
+
+void
+particles_t::update_inverse_mass () {
+  NUMA_PLACEMENT::first_touch_reserve (Minv, M.size ());
+  Minv.resize (M.size ());
+  const std::int64_t n = M.size ();
+#pragma omp parallel for schedule(static)
+  for (std::int64_t ii = 0; ii < n; ++ii)
+    Minv[ii] = M[ii] != 0. ? 1. / M[ii] : 0.;
+  mass_prop.clear ();
+}
+
+
+void
+particles_t::set_mass (std::vector<double> m) {
+  if (m.size () != static_cast<std::size_t> (grid.num_global_nodes ()))
+    throw std::invalid_argument ("mass matrix has "
+				 + std::to_string (m.size ())
+				 + " values, the grid has "
+				 + std::to_string (grid.num_global_nodes ())
+				 + " nodes");
+  M = std::move (m);
+  update_inverse_mass ();
+}
+
+
+void
+particles_t::apply_inverse_mass (std::vector<double *> const & gvars,
+				 std::vector<int> const & components) const {
+
+  QUADGRID_SPAN ("apply_mass", "transfer");
+  // without a mass matrix there is nothing to apply
+  auto const & Mi = inverse_mass ();
+  const std::int64_t n = Mi.empty () ? 0 : active_nodes.size ();
+  const std::size_t nvars = gvars.size ();
+
+#pragma omp parallel for schedule(static)
+  for (std::int64_t jj = 0; jj < n; ++jj) {
+    const std::size_t ii = active_nodes[jj];
+    const double m = Mi[ii];
+    for (std::size_t ivar = 0; ivar < nvars; ++ivar) {
+      const int nc = components.empty () ? 1 : components[ivar];
+      for (int k = 0; k < nc; ++k)
+	gvars[ivar][ii * nc + k] *= m;
+    }
+  }
+}
+
+
+void
+particles_t::p2g (field_registry_t & fields,
+		  std::vector<std::string> const & pvarnames,
+		  std::vector<field_registry_t::handle_t> const & gvars,
+		  bool apply_mass, assignment_t OP) const {
+
+  check_components (fields, gvars, pvarnames);
+
+  QUADGRID_PHASE (stats, phase_t::p2g);
+  QUADGRID_COUNT (particles, x.size () * gvars.size ());
+  QUADGRID_COUNT (cells, active_cells.size () * gvars.size ());
+
+  std::vector<double *> scattered;
+  std::vector<int> components;
+  std::size_t iprop = 0;
+  for (std::size_t ivar = 0; ivar < gvars.size (); ++ivar) {
+    QUADGRID_SPAN ("p2g_field", "transfer");
+    const int nc = fields.components (gvars[ivar]);
+    std::vector<const double *> dprop (nc);
+    for (int k = 0; k < nc; ++k)
+      dprop[k] = dprops.at (pvarnames.at (iprop++)).data ();
+
+    bool fused = false;
+    double *gvar = fields.begin_scatter (gvars[ivar], fused);
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const & plist = grd_to_ptcl.at (gidx);
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+	const idx_t idx = plist[ii];
+	const double xx = x[idx], yy = y[idx];
+	for (idx_t inode = 0; inode < 4; ++inode) {
+	  // one index and shape function for all components
+	  const idx_t n = icell.gt (inode);
+	  const double N = icell.shp (xx, yy, inode);
+	  double *g = gvar + std::size_t (n) * nc;
+	  // a pending zeroing clears each node on its first hit
+	  if (fused && fields.first_hit (n))
+	    std::fill_n (g, nc, 0.);
+	  for (int k = 0; k < nc; ++k)
+	    OP (g[k], N * dprop[k][idx]);
+	}
+      }
+    }
+    fields.end_scatter (gvars[ivar], active_cells);
+    if (apply_mass) {
+      scattered.push_back (gvar);
+      components.push_back (nc);
+    }
+  }
+
+  if (apply_mass)
+    apply_inverse_mass (scattered, components);
+}
+
+
+void
+particles_t::g2p (const field_registry_t & fields,
+		  std::vector<field_registry_t::handle_t> const & gvars,
+		  std::vector<std::string> const & pvarnames,
+		  bool apply_mass, assignment_t OP) {
+
+  check_components (fields, gvars, pvarnames);
+
+  QUADGRID_PHASE (stats, phase_t::g2p);
+  QUADGRID_COUNT (particles, x.size () * gvars.size ());
+  QUADGRID_COUNT (cells, active_cells.size () * gvars.size ());
+
+  std::size_t iprop = 0;
+  for (std::size_t ivar = 0; ivar < gvars.size (); ++ivar) {
+    QUADGRID_SPAN ("g2p_field", "transfer");
+    const int nc = fields.components (gvars[ivar]);
+    std::vector<double *> dprop (nc);
+    for (int k = 0; k < nc; ++k)
+      dprop[k] = dprops.at (pvarnames.at (iprop++)).data ();
+
+    auto const & gvar = fields[gvars[ivar]];
+    std::vector<double> w (4 * nc);
+    for (auto const & gidx : active_cells) {
+      auto const icell = grid.cell (gidx);
+      auto const & plist = grd_to_ptcl.at (gidx);
+      for (idx_t inode = 0; inode < 4; ++inode) {
+	const idx_t n = icell.gt (inode);
+	const std::size_t off = std::size_t (n) * nc;
+	for (int k = 0; k < nc; ++k)
+	  w[inode * nc + k] = apply_mass ?
+	    M[n] * gvar[off + k] : gvar[off + k];
+      }
+      for (std::size_t ii = 0; ii < plist.size (); ++ii) {
+	const idx_t idx = plist[ii];
+	const double xx = x[idx], yy = y[idx];
+	for (idx_t inode = 0; inode < 4; ++inode) {
+	  const double N = icell.shp (xx, yy, inode);
+	  for (int k = 0; k < nc; ++k)
+	    OP (dprop[k][idx], N * w[inode * nc + k]);
+	}
+      }
     }
   }
 }
@@ -138,14 +710,26 @@ particles_t::build_mass () {
 template<>
 void
 particles_t::print<particles_t::output_format::json> (std::ostream & os) const {
+  QUADGRID_PHASE (stats, phase_t::print_json);
+  QUADGRID_COUNT (particles, x.size ());
+#ifdef QUADGRID_INSTRUMENT
+  auto start = os.tellp ();
+#endif
   nlohmann::json j = *this;
   os << j;
+  QUADGRID_COUNT (bytes, start < 0 ? 0 : os.tellp () - start);
 }
 
 template<>
 void
 particles_t::print<particles_t::output_format::csv> (std::ostream & os) const {
 
+  QUADGRID_PHASE (stats, phase_t::print_csv);
+  QUADGRID_COUNT (particles, x.size ());
+#ifdef QUADGRID_INSTRUMENT
+  auto start = os.tellp ();
+#endif
+
   os << "\"x\", " << "\"y\"";
 
   for (auto const & ii : dprops)
@@ -154,21 +738,38 @@ particles_t::print<particles_t::output_format::csv> (std::ostream & os) const {
   for (auto const & ii : iprops)
     os << ", \"" << ii.first << "\"";
 
-  os << std::endl;
+  os << '\n';
+
+  std::vector<const double *> dcols;
+  for (auto const & ii : dprops)
+    dcols.push_back (ii.second.data ());
 
+  std::vector<const idx_t *> icols;
+  for (auto const & ii : iprops)
+    icols.push_back (ii.second.data ());
 
-  for (idx_t jj = 0; jj < x.size (); ++jj) {
+  ASCII_FORMAT::write_chunked
+    (os, x.size (),
+     [this, &dcols, &icols] (std::string & buf, std::size_t jj) {
 
-    os << x[jj] << ", " << y[jj];
+       ASCII_FORMAT::append (buf, x[jj]);
+       buf += ", ";
+       ASCII_FORMAT::append (buf, y[jj]);
 
-    for (auto const & ii : dprops)
-      os << ", " << std::setprecision (16) << ii.second[jj];
+       for (auto const & ii : dcols) {
+	 buf += ", ";
+	 ASCII_FORMAT::append (buf, ii[jj]);
+       }
 
-    for (auto const & ii : iprops)
-      os << ", " << ii.second[jj];
+       for (auto const & ii : icols) {
+	 buf += ", ";
+	 ASCII_FORMAT::append (buf, ii[jj]);
+       }
 
-    os << std::endl;
-  }
+       buf += '\n';
+     });
+
+  QUADGRID_COUNT (bytes, start < 0 ? 0 : os.tellp () - start);
 }
 
 template<>
@@ -176,22 +777,24 @@ void
 particles_t::print<particles_t::output_format::octave_ascii>
 (std::ostream & os) const {
 
+  QUADGRID_PHASE (stats, phase_t::print_octave_ascii);
+  QUADGRID_COUNT (particles, x.size ());
+#ifdef QUADGRID_INSTRUMENT
+  auto start = os.tellp ();
+#endif
+
   os << "# name: x" << std::endl
      << "# type: matrix" << std::endl
      << "# rows: 1" << std::endl
      << "# columns: " << x.size () << std::endl;
-  for (auto const & kk : x) {
-    os  << std::setprecision(16) << kk << " ";
-  }
+  ASCII_FORMAT::write_row (os, x.data (), x.size ());
   os << std::endl;
 
   os << "# name: y" << std::endl
      << "# type: matrix" << std::endl
      << "# rows: 1" << std::endl
      << "# columns: " << y.size () << std::endl;
-  for (auto const & kk : y) {
-    os  << std::setprecision(16) << kk << " ";
-  }
+  ASCII_FORMAT::write_row (os, y.data (), y.size ());
   os << std::endl;
 
   os << "# name: dprops" << std::endl
@@ -206,9 +809,7 @@ particles_t::print<particles_t::output_format::octave_ascii>
        << "# type: matrix" << std::endl
        << "# rows: 1" << std::endl
        << "# columns: " << ii.second.size () << std::endl;
-    for (auto const & kk : ii.second) {
-      os << std::setprecision(16) << kk << " ";
-    }
+    ASCII_FORMAT::write_row (os, ii.second.data (), ii.second.size ());
     os << std::endl;
   }
   os << std::endl;
@@ -224,12 +825,12 @@ particles_t::print<particles_t::output_format::octave_ascii>
        << "# type: int64 matrix" << std::endl
        << "# ndims: 2" << std::endl
        << "1 " << ii.second.size () << std::endl;
-    for (auto const & kk : ii.second) {
-      os << kk << " ";
-    }
+    ASCII_FORMAT::write_row (os, ii.second.data (), ii.second.size ());
     os << std::endl;
   }
   os << std::endl;
+
+  QUADGRID_COUNT (bytes, start < 0 ? 0 : os.tellp () - start);
 }
 
 void
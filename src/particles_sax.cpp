@@ -0,0 +1,272 @@
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+
+#include <particles.h>
+
+namespace {
+
+  //! @brief SAX event handler filling a `particles_t` object.
+
+  //! Keeps track of the column currently being read, every number
+  //! found below the key of a column (at any depth, so that also
+  //! nested or scalar encodings are accepted) is appended to it.
+  class
+  particles_sax_t {
+
+  public:
+
+    using json = nlohmann::json;
+    using idx_t = particles_t::idx_t;
+
+    particles_sax_t (particles_t &p_,
+		     std::map<std::string, std::vector<double>> *vars_,
+		     idx_t hint)
+      : p (p_), vars (vars_), num_particles (hint) { };
+
+    bool null () { return true; };
+    bool boolean (bool) { return true; };
+    bool string (json::string_t &) { return true; };
+    bool binary (json::binary_t &) { return true; };
+
+    bool
+    number_integer (json::number_integer_t v)
+    { return number (static_cast<double> (v), v); };
+
+    bool
+    number_unsigned (json::number_unsigned_t v)
+    { return number (static_cast<double> (v), v); };
+
+    bool
+    number_float (json::number_float_t v, const json::string_t &)
+    { return number (v, static_cast<std::int64_t> (v)); };
+
+    bool
+    start_object (std::size_t)
+    { ++depth; return true; };
+
+    bool
+    end_object () {
+      if (depth == 2)
+	section = section_t::none;
+      --depth;
+      return end_value ();
+    };
+
+    bool
+    start_array (std::size_t)
+    { ++depth; return true; };
+
+    bool
+    end_array ()
+    { --depth; return end_value (); };
+
+    bool
+    key (json::string_t &k);
+
+    // the message of `ex` already gives the position
+    bool
+    parse_error (std::size_t, const std::string &,
+		 const nlohmann::detail::exception &ex)
+    { throw std::runtime_error (ex.what ()); };
+
+    void
+    finalize ();
+
+  private:
+
+    enum class
+    section_t { none, num_particles, x, y, dprops, iprops,
+		grid_properties, grid_vars };
+
+    bool
+    number (double v, std::int64_t iv);
+
+    bool
+    end_value ();
+
+    void
+    reserve (std::size_t n);
+
+    void
+    bin (std::size_t ii)
+    {
+      if (ii > static_cast<std::size_t> (std::numeric_limits<particles_t::bin_idx_t>::max ()))
+	throw std::overflow_error ("too many particles for the binning index type");
+      p.grd_to_ptcl[p.cell_index (p.x[ii], p.y[ii])].push_back
+	(static_cast<particles_t::bin_idx_t> (ii));
+    };
+
+    particles_t                                 &p;
+    std::map<std::string, std::vector<double>>  *vars;
+    std::size_t                                  num_particles;
+
+    int                    depth = 0;
+    section_t              section = section_t::none;
+    particles_t::dcolumn_t  *dcol = nullptr;
+    particles_t::icolumn_t  *icol = nullptr;
+    std::vector<double>     *gcol = nullptr;
+    std::string            grid_key;
+    std::map<std::string, double> grid_properties;
+  };
+
+
+  bool
+  particles_sax_t::key (json::string_t &k) {
+
+    if (depth > 2)
+      return true;
+
+    dcol = nullptr;
+    icol = nullptr;
+    gcol = nullptr;
+
+    if (depth == 1) {
+      section = section_t::none;
+      if (k == "num_particles")
+	section = section_t::num_particles;
+      else if (k == "x") {
+	section = section_t::x;
+	dcol = &p.x;
+      }
+      else if (k == "y") {
+	section = section_t::y;
+	dcol = &p.y;
+      }
+      else if (k == "dprops")
+	section = section_t::dprops;
+      else if (k == "iprops")
+	section = section_t::iprops;
+      else if (k == "grid_properties")
+	section = section_t::grid_properties;
+      else if (k == "grid_vars" && vars != nullptr)
+	section = section_t::grid_vars;
+    }
+    else if (depth == 2) {
+      switch (section) {
+      case section_t::dprops :
+	dcol = &p.dprops[k];
+	break;
+      case section_t::iprops :
+	icol = &p.iprops[k];
+	break;
+      case section_t::grid_vars :
+	gcol = &(*vars)[k];
+	break;
+      case section_t::grid_properties :
+	grid_key = k;
+	break;
+      default :
+	break;
+      }
+    }
+
+    if (dcol != nullptr)
+      dcol->reserve (num_particles);
+    if (icol != nullptr)
+      icol->reserve (num_particles);
+
+    return true;
+  }
+
+
+  bool
+  particles_sax_t::number (double v, std::int64_t iv) {
+
+    if (section == section_t::num_particles && depth == 1) {
+      reserve (iv);
+    }
+    else if (section == section_t::grid_properties && depth == 2) {
+      grid_properties[grid_key] = v;
+    }
+    else if (dcol != nullptr) {
+      dcol->push_back (v);
+      const std::size_t ii = dcol->size () - 1;
+      if ((section == section_t::x && ii < p.y.size ())
+	  || (section == section_t::y && ii < p.x.size ()))
+	bin (ii);
+    }
+    else if (icol != nullptr) {
+      icol->push_back (static_cast<idx_t> (iv));
+    }
+    else if (gcol != nullptr) {
+      gcol->push_back (v);
+    }
+
+    return end_value ();
+  }
+
+
+  bool
+  particles_sax_t::end_value () {
+    // once the first particle column is complete the number
+    // of particles is known, reserve space for all other columns
+    if (num_particles == 0 && depth == 1
+	&& (section == section_t::x || section == section_t::y))
+      reserve (dcol->size ());
+    else if (num_particles == 0 && depth == 2
+	     && (section == section_t::dprops
+		 || section == section_t::iprops)
+	     && (dcol != nullptr || icol != nullptr))
+      reserve (dcol != nullptr ? dcol->size () : icol->size ());
+    return true;
+  }
+
+
+  void
+  particles_sax_t::reserve (std::size_t n) {
+    if (n == 0 || num_particles != 0)
+      return;
+    num_particles = n;
+    p.reserve (static_cast<idx_t> (n));
+  }
+
+
+  void
+  particles_sax_t::finalize () {
+
+    if (p.x.size () != p.y.size ())
+      throw std::runtime_error ("x and y have different length in json input");
+
+    p.num_particles = p.x.size ();
+    p.update_active_cells ();
+
+    // only columns read before the number of particles
+    // was known may have excess capacity
+    p.x.shrink_to_fit ();
+    p.y.shrink_to_fit ();
+    for (auto & ii : p.dprops)
+      ii.second.shrink_to_fit ();
+    for (auto & ii : p.iprops)
+      ii.second.shrink_to_fit ();
+
+    if (! grid_properties.empty ()) {
+      auto differs = [] (double a, double b) {
+	return std::abs (a - b) > 1.0e-12 * std::max (std::abs (a), std::abs (b));
+      };
+      if (differs (grid_properties["nx"], p.grid.num_cols ())
+	  || differs (grid_properties["ny"], p.grid.num_rows ())
+	  || differs (grid_properties["hx"], p.grid.hx ())
+	  || differs (grid_properties["hy"], p.grid.hy ()))
+	throw std::runtime_error ("grid_properties in json input do not match the grid");
+    }
+  }
+
+}
+
+
+particles_t::particles_t (std::istream &is,
+			  const quadgrid_t<std::vector<double>>& grid_,
+			  std::map<std::string, std::vector<double>> *grid_vars,
+			  idx_t num_particles_hint,
+			  std::pmr::memory_resource *mr)
+  : particles_t (0, grid_, mr) {
+
+  particles_sax_t handler (*this, grid_vars, num_particles_hint);
+  x.reserve (num_particles_hint);
+  y.reserve (num_particles_hint);
+  nlohmann::json::sax_parse (is, &handler);
+  handler.finalize ();
+}
@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <quadtree.h>
+
+
+double
+quadtree_t::cell_t::p (idx_t i, idx_t j) const {
+  auto const & n = tree->tree_nodes[tree->leaves[leaf]];
+  if (i == 0)
+    return (n.i + (j >= 2 ? 1 : 0)) * hx ();
+  return (n.j + (j % 2 ? 1 : 0)) * hy ();
+}
+
+
+quadtree_t::idx_t
+quadtree_t::cell_t::level () const {
+  return tree->tree_nodes[tree->leaves[leaf]].level;
+}
+
+
+double
+quadtree_t::cell_t::hx () const {
+  return std::ldexp (tree->base.hx (), -level ());
+}
+
+
+double
+quadtree_t::cell_t::hy () const {
+  return std::ldexp (tree->base.hy (), -level ());
+}
+
+
+double
+quadtree_t::cell_t::shp (double x, double y, idx_t inode) const {
+  const double xi = (x - p (0, 0)) / hx ();
+  const double eta = (y - p (1, 0)) / hy ();
+  switch (inode) {
+  case 3 :
+    return xi * eta;
+  case 2 :
+    return xi * (1. - eta);
+  case 1 :
+    return (1. - xi) * eta;
+  case 0 :
+    return (1. - xi) * (1. - eta);
+  default :
+    throw std::out_of_range ("inode must be in range 0..3");
+  }
+}
+
+
+double
+quadtree_t::cell_t::shg (double x, double y, idx_t idir, idx_t inode) const {
+  const double xi = (x - p (0, 0)) / hx ();
+  const double eta = (y - p (1, 0)) / hy ();
+  const double dxi = (inode >= 2 ? 1. : -1.) / hx ();
+  const double deta = (inode % 2 ? 1. : -1.) / hy ();
+  const double fxi = inode >= 2 ? xi : 1. - xi;
+  const double feta = inode % 2 ? eta : 1. - eta;
+  if (inode < 0 || inode > 3)
+    throw std::out_of_range ("inode must be in range 0..3");
+  return idir == 0 ? dxi * feta : fxi * deta;
+}
+
+
+quadtree_t::quadtree_t (const quadgrid_t<std::vector<double>> &base_,
+			idx_t max_level_)
+  : base (base_), max_level (max_level_) {
+
+  if (max_level < 0 || max_level > 20)
+    throw std::invalid_argument ("quadtree_t: max_level must be in 0..20");
+
+  // lattice fine enough to hold midpoints of the finest leaves,
+  // points are keyed by a single 64 bit integer
+  lattice_rows = static_cast<std::int64_t> (base.num_rows ()) << (max_level + 1);
+  const std::int64_t lattice_cols
+    = static_cast<std::int64_t> (base.num_cols ()) << (max_level + 1);
+  if (lattice_cols + 1 > std::numeric_limits<std::int64_t>::max () / (lattice_rows + 1))
+    throw std::invalid_argument ("quadtree_t: max_level too large"
+				 " for the size of the base grid");
+
+  // roots in the same order as the cells of the base grid
+  tree_nodes.reserve (base.num_global_cells ());
+  for (idx_t idx = 0; idx < base.num_global_cells (); ++idx)
+    tree_nodes.push_back (tree_node_t{0, base.gind2col (idx),
+				      base.gind2row (idx), -1, -1});
+
+  update ();
+}
+
+
+void
+quadtree_t::split (idx_t leaf) {
+
+  const idx_t n = leaves.at (leaf);
+  if (tree_nodes[n].child >= 0)
+    return;
+  if (tree_nodes[n].level >= max_level)
+    throw std::out_of_range ("quadtree_t: cannot refine beyond max_level");
+  split_node (n);
+}
+
+
+quadtree_t::idx_t
+quadtree_t::split_node (idx_t n) {
+  const idx_t child = static_cast<idx_t> (tree_nodes.size ());
+  const auto parent = tree_nodes[n];
+  for (idx_t k = 0; k < 4; ++k)
+    tree_nodes.push_back (tree_node_t{parent.level + 1,
+				      2 * parent.i + k % 2,
+				      2 * parent.j + k / 2, -1, -1});
+  tree_nodes[n].child = child;
+  tree_nodes[n].leaf = -1;
+  return child;
+}
+
+
+void
+quadtree_t::collect_leaves () {
+
+  leaves.clear ();
+  std::vector<idx_t> stack;
+  const idx_t num_roots = base.num_global_cells ();
+  for (idx_t root = 0; root < num_roots; ++root) {
+    stack.push_back (root);
+    while (! stack.empty ()) {
+      const idx_t n = stack.back ();
+      stack.pop_back ();
+      if (tree_nodes[n].child < 0) {
+	tree_nodes[n].leaf = static_cast<idx_t> (leaves.size ());
+	leaves.push_back (n);
+      }
+      else
+	for (idx_t k = 3; k >= 0; --k)
+	  stack.push_back (tree_nodes[n].child + k);
+    }
+  }
+}
+
+
+quadtree_t::idx_t
+quadtree_t::locate_lattice (std::int64_t X, std::int64_t Y) const {
+
+  const int D = max_level + 1;
+  const idx_t c = static_cast<idx_t> (X >> D);
+  const idx_t r = static_cast<idx_t> (Y >> D);
+  idx_t n = base.sub2gind (r, c);
+  while (tree_nodes[n].child >= 0) {
+    const int shift = D - tree_nodes[n].level - 1;
+    n = tree_nodes[n].child + ((X >> shift) & 1) + 2 * ((Y >> shift) & 1);
+  }
+  return n;
+}
+
+
+quadtree_t::idx_t
+quadtree_t::locate (double x, double y) const {
+  const int D = max_level + 1;
+  const std::int64_t nx = static_cast<std::int64_t> (base.num_cols ()) << D;
+  const std::int64_t ny = lattice_rows;
+  auto X = static_cast<std::int64_t> (std::floor (std::ldexp (x / base.hx (), D)));
+  auto Y = static_cast<std::int64_t> (std::floor (std::ldexp (y / base.hy (), D)));
+  X = std::min (std::max (X, std::int64_t (0)), nx - 1);
+  Y = std::min (std::max (Y, std::int64_t (0)), ny - 1);
+  return tree_nodes[locate_lattice (X, Y)].leaf;
+}
+
+
+void
+quadtree_t::update () {
+
+  const int D = max_level + 1;
+  const std::int64_t nx = static_cast<std::int64_t> (base.num_cols ()) << D;
+  const std::int64_t ny = lattice_rows;
+
+  // 2:1 balance across edges: refine any leaf which is more than
+  // one level coarser than a neighbor
+  for (bool changed = true; changed; ) {
+    changed = false;
+    collect_leaves ();
+    for (auto n : leaves) {
+      if (tree_nodes[n].child >= 0)
+	continue;
+      auto const nd = tree_nodes[n];
+      if (nd.level < 2)
+	continue;
+      const std::int64_t s = std::int64_t (1) << (D - nd.level);
+      const std::int64_t X0 = nd.i * s, Y0 = nd.j * s;
+      const std::pair<std::int64_t, std::int64_t> outside[4] = {
+	{X0 + s / 2, Y0 - 1}, {X0 + s / 2, Y0 + s},
+	{X0 - 1, Y0 + s / 2}, {X0 + s, Y0 + s / 2}
+      };
+      for (auto const & q : outside) {
+	if (q.first < 0 || q.second < 0 || q.first >= nx || q.second >= ny)
+	  continue;
+	const idx_t m = locate_lattice (q.first, q.second);
+	if (tree_nodes[m].level < nd.level - 1) {
+	  split_node (m);
+	  changed = true;
+	}
+      }
+    }
+  }
+  collect_leaves ();
+
+  // number nodes, corners of each leaf in the same order as cell_t
+  std::unordered_map<std::uint64_t, idx_t> node_id;
+  node_x.clear ();
+  node_y.clear ();
+  leaf_nodes.assign (leaves.size () * nodes_per_cell, 0);
+  const double dx = std::ldexp (base.hx (), -D);
+  const double dy = std::ldexp (base.hy (), -D);
+  for (std::size_t l = 0; l < leaves.size (); ++l) {
+    auto const & nd = tree_nodes[leaves[l]];
+    const std::int64_t s = std::int64_t (1) << (D - nd.level);
+    for (idx_t k = 0; k < nodes_per_cell; ++k) {
+      const std::int64_t X = nd.i * s + (k >= 2 ? s : 0);
+      const std::int64_t Y = nd.j * s + (k % 2 ? s : 0);
+      auto ins = node_id.emplace (lattice_key (X, Y),
+				  static_cast<idx_t> (node_x.size ()));
+      if (ins.second) {
+	node_x.push_back (X * dx);
+	node_y.push_back (Y * dy);
+      }
+      leaf_nodes[l * nodes_per_cell + k] = ins.first->second;
+    }
+  }
+
+  // a node at the midpoint of an edge of a leaf is hanging
+  hang_a.assign (node_x.size (), NOT_HANGING);
+  hang_b.assign (node_x.size (), NOT_HANGING);
+  static const idx_t edges[4][2] = {{0, 2}, {1, 3}, {0, 1}, {2, 3}};
+  for (std::size_t l = 0; l < leaves.size (); ++l) {
+    auto const & nd = tree_nodes[leaves[l]];
+    const std::int64_t s = std::int64_t (1) << (D - nd.level);
+    for (auto const & e : edges) {
+      const std::int64_t Xm = nd.i * s + ((e[0] >= 2 ? s : 0) + (e[1] >= 2 ? s : 0)) / 2;
+      const std::int64_t Ym = nd.j * s + ((e[0] % 2 ? s : 0) + (e[1] % 2 ? s : 0)) / 2;
+      auto it = node_id.find (lattice_key (Xm, Ym));
+      if (it != node_id.end ()) {
+	hang_a[it->second] = leaf_nodes[l * nodes_per_cell + e[0]];
+	hang_b[it->second] = leaf_nodes[l * nodes_per_cell + e[1]];
+      }
+    }
+  }
+
+  leaf_to_ptcl.clear ();
+  M.clear ();
+}
+
+
+quadtree_t::idx_t
+quadtree_t::num_hanging_nodes () const {
+  return static_cast<idx_t>
+    (std::count_if (hang_a.begin (), hang_a.end (),
+		    [] (idx_t a) { return a != NOT_HANGING; }));
+}
+
+
+void
+quadtree_t::refine (const particles_t &p, idx_t max_particles_per_leaf) {
+
+  // split overfull leaves recursively, moving the particle lists down
+  std::vector<std::pair<idx_t, std::vector<idx_t>>> stack;
+  {
+    std::map<idx_t, std::vector<idx_t>> in_leaf;
+    for (idx_t ii = 0; ii < static_cast<idx_t> (p.x.size ()); ++ii)
+      in_leaf[leaves[locate (p.x[ii], p.y[ii])]].push_back (ii);
+    for (auto & ii : in_leaf)
+      stack.emplace_back (ii.first, std::move (ii.second));
+  }
+
+  while (! stack.empty ()) {
+    auto item = std::move (stack.back ());
+    stack.pop_back ();
+    const idx_t n = item.first;
+    if (static_cast<idx_t> (item.second.size ()) <= max_particles_per_leaf
+	|| tree_nodes[n].level >= max_level)
+      continue;
+
+    const auto parent = tree_nodes[n];
+    const idx_t child = split_node (n);
+
+    std::vector<idx_t> lists[4];
+    const double hx = std::ldexp (base.hx (), -(parent.level + 1));
+    const double hy = std::ldexp (base.hy (), -(parent.level + 1));
+    for (auto ii : item.second) {
+      const auto di = std::min<std::int64_t>
+	(1, std::max<std::int64_t> (0, static_cast<std::int64_t> (std::floor (p.x[ii] / hx)) - 2 * parent.i));
+      const auto dj = std::min<std::int64_t>
+	(1, std::max<std::int64_t> (0, static_cast<std::int64_t> (std::floor (p.y[ii] / hy)) - 2 * parent.j));
+      lists[di + 2 * dj].push_back (ii);
+    }
+    for (idx_t k = 0; k < 4; ++k)
+      stack.emplace_back (child + k, std::move (lists[k]));
+  }
+
+  update ();
+  bin (p);
+}
+
+
+void
+quadtree_t::bin (const particles_t &p) {
+  leaf_to_ptcl.clear ();
+  for (idx_t ii = 0; ii < static_cast<idx_t> (p.x.size ()); ++ii)
+    leaf_to_ptcl[locate (p.x[ii], p.y[ii])].push_back (ii);
+}
+
+
+void
+quadtree_t::make_conforming (std::vector<double> &v) const {
+  for (idx_t ii = 0; ii < num_global_nodes (); ++ii)
+    if (hang_a[ii] != NOT_HANGING)
+      v[ii] = .5 * (v[hang_a[ii]] + v[hang_b[ii]]);
+}
+
+
+void
+quadtree_t::build_mass () {
+
+  M.assign (num_global_nodes (), 0.);
+  for (auto icell = begin_cell_sweep (); icell != end_cell_sweep (); ++icell)
+    for (idx_t k = 0; k < nodes_per_cell; ++k)
+      M[icell->gt (k)] += icell->hx () * icell->hy () / 4.;
+
+  for (idx_t ii = 0; ii < num_global_nodes (); ++ii)
+    if (hang_a[ii] != NOT_HANGING) {
+      M[hang_a[ii]] += .5 * M[ii];
+      M[hang_b[ii]] += .5 * M[ii];
+      M[ii] = 0.;
+    }
+}
+
+
+void
+quadtree_t::p2g (const particles_t &p,
+		 std::map<std::string, std::vector<double>> &vars,
+		 const std::vector<std::string> &pvarnames,
+		 const std::vector<std::string> &gvarnames,
+		 bool apply_mass) const {
+
+  for (std::size_t ivar = 0; ivar < gvarnames.size (); ++ivar) {
+
+    auto & gvar = vars[gvarnames[ivar]];
+    gvar.resize (num_global_nodes (), 0.);
+    auto const & dprop = p.dprops.at (pvarnames[ivar]);
+
+    for (auto const & ic : leaf_to_ptcl) {
+      const cell_t cell (*this, ic.first);
+      for (auto idx : ic.second)
+	for (idx_t k = 0; k < nodes_per_cell; ++k)
+	  gvar[cell.gt (k)] += cell.shp (p.x[idx], p.y[idx], k) * dprop[idx];
+    }
+
+    // the basis function of a hanging node is half that of each
+    // of the nodes constraining it
+    for (idx_t ii = 0; ii < num_global_nodes (); ++ii)
+      if (hang_a[ii] != NOT_HANGING) {
+	gvar[hang_a[ii]] += .5 * gvar[ii];
+	gvar[hang_b[ii]] += .5 * gvar[ii];
+	gvar[ii] = 0.;
+      }
+
+    if (apply_mass) {
+      for (idx_t ii = 0; ii < num_global_nodes (); ++ii)
+	if (hang_a[ii] == NOT_HANGING)
+	  gvar[ii] /= M[ii];
+      make_conforming (gvar);
+    }
+  }
+}
+
+
+void
+quadtree_t::g2p (particles_t &p,
+		 const std::map<std::string, std::vector<double>> &vars,
+		 const std::vector<std::string> &gvarnames,
+		 const std::vector<std::string> &pvarnames,
+		 assignment_t OP) const {
+
+  auto value = [this] (const std::vector<double> &v, idx_t ii) {
+    return hang_a[ii] == NOT_HANGING ? v[ii]
+      : .5 * (v[hang_a[ii]] + v[hang_b[ii]]);
+  };
+
+  for (std::size_t ivar = 0; ivar < gvarnames.size (); ++ivar) {
+
+    auto const & gvar = vars.at (gvarnames[ivar]);
+    auto & dprop = p.dprops.at (pvarnames[ivar]);
+
+    for (auto const & ic : leaf_to_ptcl) {
+      const cell_t cell (*this, ic.first);
+      double u[nodes_per_cell];
+      for (idx_t k = 0; k < nodes_per_cell; ++k)
+	u[k] = value (gvar, cell.gt (k));
+      for (auto idx : ic.second) {
+	double s = 0.;
+	for (idx_t k = 0; k < nodes_per_cell; ++k)
+	  s += cell.shp (p.x[idx], p.y[idx], k) * u[k];
+	OP (dprop[idx], s);
+      }
+    }
+  }
+}
+
+
+void
+quadtree_t::vtk_export (const char *filename,
+			const std::map<std::string, std::vector<double>> &f) const {
+
+  std::ofstream ofs (filename);
+  ofs << std::setprecision (16);
+  ofs << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\">\n"
+      << "  <UnstructuredGrid>\n"
+      << "    <Piece NumberOfPoints=\"" << num_global_nodes ()
+      << "\" NumberOfCells=\"" << num_global_cells () << "\">\n";
+
+  ofs << "      <Points>\n        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"ascii\">\n";
+  for (idx_t ii = 0; ii < num_global_nodes (); ++ii)
+    ofs << node_x[ii] << " " << node_y[ii] << " 0\n";
+  ofs << "        </DataArray>\n      </Points>\n";
+
+  // VTK_QUAD nodes go counterclockwise
+  ofs << "      <Cells>\n        <DataArray type=\"Int64\" Name=\"connectivity\" format=\"ascii\">\n";
+  for (auto icell = begin_cell_sweep (); icell != end_cell_sweep (); ++icell)
+    ofs << icell->gt (0) << " " << icell->gt (2) << " "
+	<< icell->gt (3) << " " << icell->gt (1) << "\n";
+  ofs << "        </DataArray>\n        <DataArray type=\"Int64\" Name=\"offsets\" format=\"ascii\">\n";
+  for (idx_t ii = 1; ii <= num_global_cells (); ++ii)
+    ofs << nodes_per_cell * ii << " ";
+  ofs << "\n        </DataArray>\n        <DataArray type=\"UInt8\" Name=\"types\" format=\"ascii\">\n";
+  for (idx_t ii = 0; ii < num_global_cells (); ++ii)
+    ofs << "9 ";
+  ofs << "\n        </DataArray>\n      </Cells>\n";
+
+  ofs << "      <PointData>\n";
+  for (auto const & ii : f) {
+    ofs << "        <DataArray type=\"Float64\" Name=\"" << ii.first << "\" format=\"ascii\">\n";
+    for (auto const & jj : ii.second)
+      ofs << jj << " ";
+    ofs << "\n        </DataArray>\n";
+  }
+  ofs << "      </PointData>\n";
+
+  ofs << "      <CellData>\n        <DataArray type=\"Int32\" Name=\"level\" format=\"ascii\">\n";
+  for (auto icell = begin_cell_sweep (); icell != end_cell_sweep (); ++icell)
+    ofs << icell->level () << " ";
+  ofs << "\n        </DataArray>\n      </CellData>\n";
+
+  ofs << "    </Piece>\n  </UnstructuredGrid>\n</VTKFile>\n";
+  ofs.close ();
+}
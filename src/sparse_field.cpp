@@ -0,0 +1,91 @@
+#include <algorithm>
+
+#include <sparse_field.h>
+
+
+sparse_field_t::sparse_field_t (const quadgrid_t<std::vector<double>> &grid_)
+  : sparse_field_t (grid_.num_rows (), grid_.num_cols ()) {
+  grid = &grid_;
+}
+
+
+sparse_field_t::sparse_field_t (idx_t numrows, idx_t numcols)
+  : grid (nullptr), nnr (numrows + 1), nnc (numcols + 1),
+    ntr ((numrows + tile_size) / tile_size),
+    ntc ((numcols + tile_size) / tile_size),
+    page_table (static_cast<std::size_t> (ntr) * ntc, no_tile) { }
+
+
+sparse_field_t::idx_t
+sparse_field_t::allocate_tile (idx_t page) {
+
+  idx_t t = 0;
+  if (! free_tiles.empty ()) {
+    t = free_tiles.back ();
+    free_tiles.pop_back ();
+    std::fill_n (pool.begin () + t * tile_nodes, tile_nodes, 0.);
+    tile_page[t] = page;
+  }
+  else {
+    t = static_cast<idx_t> (tile_page.size ());
+    tile_page.push_back (page);
+    pool.resize (pool.size () + tile_nodes, 0.);
+  }
+
+  page_table[page] = t;
+  return t;
+}
+
+
+void
+sparse_field_t::clear () {
+  for (idx_t t = 0; t < static_cast<idx_t> (tile_page.size ()); ++t)
+    if (tile_page[t] != no_tile) {
+      page_table[tile_page[t]] = no_tile;
+      tile_page[t] = no_tile;
+      free_tiles.push_back (t);
+    }
+}
+
+
+void
+sparse_field_t::shrink_to_fit () {
+
+  std::vector<idx_t> new_tile_page;
+  std::vector<double> new_pool;
+  new_tile_page.reserve (num_allocated_tiles ());
+  new_pool.reserve (static_cast<std::size_t> (num_allocated_tiles ()) * tile_nodes);
+
+  for (idx_t t = 0; t < static_cast<idx_t> (tile_page.size ()); ++t)
+    if (tile_page[t] != no_tile) {
+      page_table[tile_page[t]] = static_cast<idx_t> (new_tile_page.size ());
+      new_tile_page.push_back (tile_page[t]);
+      new_pool.insert (new_pool.end (), pool.begin () + t * tile_nodes,
+		       pool.begin () + (t + 1) * tile_nodes);
+    }
+
+  tile_page.swap (new_tile_page);
+  pool.swap (new_pool);
+  std::vector<idx_t> ().swap (free_tiles);
+}
+
+
+std::vector<double>
+sparse_field_t::to_dense () const {
+  std::vector<double> d (size (), 0.);
+  for_each ([&d] (idx_t inode, double v) { d[inode] = v; });
+  return d;
+}
+
+
+void
+sparse_field_t::memory_report (memory_report_t &r,
+			       const std::string &name) const {
+  r.add_vector ("fields", name + " (page table)", page_table);
+  r.add_vector ("fields", name + " (tile map)", tile_page);
+  r.add_vector ("fields", name + " (free list)", free_tiles);
+  // free tiles of the pool count as reserved only
+  r.add ("fields", name + " (tiles)",
+	 static_cast<std::size_t> (num_allocated_tiles ()) * tile_nodes
+	 * sizeof (double), pool.capacity () * sizeof (double));
+}
@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <fstream>
+#include <mpi.h>
+#include <stdexcept>
+
+#include <tracer.h>
+
+
+tracer_t &
+tracer_t::instance () {
+  static tracer_t the_tracer;
+  return the_tracer;
+}
+
+
+tracer_t::buffer_t &
+tracer_t::thread_buffer () {
+  // buffers are owned by the tracer, so spans recorded by
+  // threads that have already terminated are not lost
+  thread_local buffer_t *buf = nullptr;
+  if (buf == nullptr) {
+    std::unique_lock<std::mutex> lock (mtx);
+    buffers.push_back (std::make_unique<buffer_t> ());
+    buf = buffers.back ().get ();
+    buf->tid = static_cast<int> (buffers.size ()) - 1;
+  }
+  return *buf;
+}
+
+
+void
+tracer_t::record (const char *name, const char *cat,
+		  std::uint64_t begin, std::uint64_t end) {
+  thread_buffer ().events.push_back (event_t{name, cat, begin, end});
+}
+
+
+void
+tracer_t::clear () {
+  std::unique_lock<std::mutex> lock (mtx);
+  for (auto & b : buffers)
+    b->events.clear ();
+}
+
+
+std::string
+tracer_t::write (const std::string &prefix) const {
+
+  int rank = 0, flag = 0;
+  MPI_Initialized (&flag);
+  if (flag)
+    MPI_Comm_rank (MPI_COMM_WORLD, &rank);
+
+  std::string filename = prefix + "_" + std::to_string (rank) + ".json";
+  std::ofstream os (filename);
+  if (! os)
+    throw std::runtime_error ("tracer_t: cannot open " + filename);
+
+  std::unique_lock<std::mutex> lock (mtx);
+
+  // timestamps are in microseconds, as required by the format
+  auto us = [] (std::uint64_t ns) {
+    char buf[32];
+    std::snprintf (buf, sizeof (buf), "%llu.%03llu",
+		   static_cast<unsigned long long> (ns / 1000),
+		   static_cast<unsigned long long> (ns % 1000));
+    return std::string (buf);
+  };
+
+  os << "{\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n";
+  os << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << rank
+     << ", \"tid\": 0, \"args\": {\"name\": \"rank " << rank << "\"}}";
+  for (auto const & b : buffers) {
+    os << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << rank
+       << ", \"tid\": " << b->tid << ", \"args\": {\"name\": \"thread "
+       << b->tid << "\"}}";
+    for (auto const & e : b->events)
+      os << ",\n{\"name\": \"" << e.name << "\", \"cat\": \"" << e.cat
+	 << "\", \"ph\": \"X\", \"ts\": " << us (e.begin)
+	 << ", \"dur\": " << us (e.end - e.begin)
+	 << ", \"pid\": " << rank << ", \"tid\": " << b->tid << "}";
+  }
+  os << "\n]}\n";
+  os.close ();
+  return filename;
+}
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <ascii_format.h>
+#include <content_hash.h>
+#include <vtk_series.h>
+
+namespace {
+
+  const char *
+  vtk_int_type () {
+    return sizeof (particles_t::idx_t) == 8 ? "Int64" : "Int32";
+  }
+
+}
+
+
+vtk_series_t::vtk_series_t (const std::string &basename_,
+			    const quadgrid_t<std::vector<double>> &grid_,
+			    idx_t particle_stride)
+  : grid (grid_), stride (std::max (particle_stride, idx_t (1))),
+    basename (basename_), stem (basename_),
+    particle_part {-1, 0, ""}, num_parts (0), step (0),
+    files_written (0) {
+
+  auto slash = basename.find_last_of ('/');
+  if (slash != std::string::npos)
+    stem = basename.substr (slash + 1);
+
+  const std::string filename = basename + ".pvd";
+  pvd.open (filename, std::ios::out | std::ios::trunc);
+  if (! pvd)
+    throw std::runtime_error ("cannot open collection file " + filename);
+
+  pvd << "<?xml version=\"1.0\"?>\n"
+      << "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"LittleEndian\">\n"
+      << "  <Collection>\n";
+  footer_pos = pvd.tellp ();
+  pvd << "  </Collection>\n</VTKFile>\n";
+  pvd.flush ();
+}
+
+
+vtk_series_t::part_t &
+vtk_series_t::get_part (const std::string &name) {
+  auto ip = parts.find (name);
+  if (ip == parts.end ())
+    ip = parts.emplace (name, part_t {num_parts++, 0, ""}).first;
+  return ip->second;
+}
+
+
+void
+vtk_series_t::write_step (double time,
+			  const std::map<std::string, std::vector<double>> &vars) {
+  std::vector<part_t *> written;
+  write_grid_fields (vars, written);
+  append_to_collection (time, written);
+  ++step;
+}
+
+
+void
+vtk_series_t::write_grid_fields
+(const std::map<std::string, std::vector<double>> &vars,
+ std::vector<part_t *> &written) {
+  using CONTENT_HASH::hash_vector;
+  using CONTENT_HASH::hash_string;
+  for (auto const & ii : vars) {
+    part_t &part = get_part (ii.first);
+    const std::uint64_t h = hash_vector (ii.second, hash_string (ii.first, 0));
+    if (part.file.empty () || h != part.hash) {
+      part.hash = h;
+      write_grid_field (ii.first, ii.second, part);
+    }
+    written.push_back (&part);
+  }
+}
+
+
+void
+vtk_series_t::write_step (double time,
+			  const std::map<std::string, std::vector<double>> &vars,
+			  const particles_t &p,
+			  const std::vector<std::string> &dpropnames,
+			  const std::vector<std::string> &ipropnames) {
+
+  using CONTENT_HASH::hash_vector;
+  using CONTENT_HASH::hash_string;
+  std::vector<part_t *> written;
+  write_grid_fields (vars, written);
+
+  if (p.num_particles > 0) {
+
+    std::vector<std::string> dnames = dpropnames, inames = ipropnames;
+    if (dnames.empty () && inames.empty ()) {
+      for (auto const & ii : p.dprops)
+	dnames.push_back (ii.first);
+      for (auto const & ii : p.iprops)
+	inames.push_back (ii.first);
+    }
+
+    std::uint64_t h = hash_vector (p.y, hash_vector (p.x, 0, stride), stride);
+    for (auto const & ii : dnames)
+      h = hash_vector (p.dprops.at (ii), hash_string (ii, h), stride);
+    for (auto const & ii : inames)
+      h = hash_vector (p.iprops.at (ii), hash_string (ii, h), stride);
+
+    if (particle_part.index < 0)
+      particle_part.index = num_parts++;
+    if (particle_part.file.empty () || h != particle_part.hash) {
+      particle_part.hash = h;
+      write_particles (p, dnames, inames, particle_part);
+    }
+    written.push_back (&particle_part);
+  }
+
+  append_to_collection (time, written);
+  ++step;
+}
+
+
+void
+vtk_series_t::write_grid_field (const std::string &name,
+				const std::vector<double> &f,
+				part_t &part) {
+
+  if (f.size () != static_cast<std::size_t> (grid.num_global_nodes ()))
+    throw std::length_error ("grid field " + name + " has wrong size");
+
+  part.file = stem + "_" + name + "_" + std::to_string (step) + ".vti";
+  const std::string filename = basename + "_" + name + "_"
+    + std::to_string (step) + ".vti";
+  std::ofstream ofs (filename);
+
+  const idx_t nr = grid.num_rows (), nc = grid.num_cols ();
+
+  ofs << "<?xml version=\"1.0\"?>\n"
+      << "<VTKFile type=\"ImageData\" version=\"0.1\" byte_order=\"LittleEndian\">\n"
+      << "  <ImageData WholeExtent=\"0 " << nc << " 0 " << nr << " 0 0\""
+      << " Origin=\"0 0 0\" Spacing=\"" << std::setprecision (16)
+      << grid.hx () << " " << grid.hy () << " 1\">\n"
+      << "    <Piece Extent=\"0 " << nc << " 0 " << nr << " 0 0\">\n"
+      << "      <PointData Scalars=\"" << name << "\">\n"
+      << "        <DataArray type=\"Float64\" Name=\"" << name
+      << "\" format=\"ascii\">\n";
+
+  // ImageData is ordered with x varying fastest, grid nodes
+  // are numbered according to the ordering of the grid
+  const std::size_t nnc = nc + 1;
+  ASCII_FORMAT::write_chunked
+    (ofs, f.size (), [this, &f, nnc] (std::string &buf, std::size_t ii) {
+      ASCII_FORMAT::append (buf, f[grid.node_sub2gind (ii / nnc, ii % nnc)]);
+      buf += (ii % nnc == nnc - 1) ? '\n' : ' ';
+    });
+
+  ofs << "        </DataArray>\n"
+      << "      </PointData>\n"
+      << "      <CellData>\n"
+      << "      </CellData>\n"
+      << "    </Piece>\n"
+      << "  </ImageData>\n"
+      << "</VTKFile>\n";
+  ofs.close ();
+  ++files_written;
+}
+
+
+void
+vtk_series_t::write_particles (const particles_t &p,
+			       const std::vector<std::string> &dpropnames,
+			       const std::vector<std::string> &ipropnames,
+			       part_t &part) {
+
+  part.file = stem + "_particles_" + std::to_string (step) + ".vtp";
+  const std::string filename = basename + "_particles_"
+    + std::to_string (step) + ".vtp";
+  std::ofstream ofs (filename);
+
+  const std::size_t n = (p.x.size () + stride - 1) / stride;
+  const std::size_t s = stride;
+
+  ofs << "<?xml version=\"1.0\"?>\n"
+      << "<VTKFile type=\"PolyData\" version=\"0.1\" byte_order=\"LittleEndian\">\n"
+      << "  <PolyData>\n"
+      << "    <Piece NumberOfPoints=\"" << n << "\" NumberOfVerts=\"" << n
+      << "\" NumberOfLines=\"0\" NumberOfStrips=\"0\" NumberOfPolys=\"0\">\n"
+      << "      <PointData>\n";
+
+  for (auto const & name : dpropnames) {
+    auto const & v = p.dprops.at (name);
+    ofs << "        <DataArray type=\"Float64\" Name=\"" << name
+	<< "\" format=\"ascii\">\n";
+    ASCII_FORMAT::write_chunked
+      (ofs, n, [&v, s] (std::string &buf, std::size_t ii) {
+	ASCII_FORMAT::append (buf, v[ii * s]);
+	buf += '\n';
+      });
+    ofs << "        </DataArray>\n";
+  }
+
+  for (auto const & name : ipropnames) {
+    auto const & v = p.iprops.at (name);
+    ofs << "        <DataArray type=\"" << vtk_int_type () << "\" Name=\""
+	<< name << "\" format=\"ascii\">\n";
+    ASCII_FORMAT::write_chunked
+      (ofs, n, [&v, s] (std::string &buf, std::size_t ii) {
+	ASCII_FORMAT::append (buf, v[ii * s]);
+	buf += '\n';
+      });
+    ofs << "        </DataArray>\n";
+  }
+
+  ofs << "      </PointData>\n"
+      << "      <Points>\n"
+      << "        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"ascii\">\n";
+  ASCII_FORMAT::write_chunked
+    (ofs, n, [&p, s] (std::string &buf, std::size_t ii) {
+      ASCII_FORMAT::append (buf, p.x[ii * s]);
+      buf += ' ';
+      ASCII_FORMAT::append (buf, p.y[ii * s]);
+      buf += " 0\n";
+    });
+  ofs << "        </DataArray>\n"
+      << "      </Points>\n"
+      << "      <Verts>\n"
+      << "        <DataArray type=\"Int64\" Name=\"connectivity\" format=\"ascii\">\n";
+  ASCII_FORMAT::write_chunked
+    (ofs, n, [] (std::string &buf, std::size_t ii) {
+      ASCII_FORMAT::append (buf, ii);
+      buf += '\n';
+    });
+  ofs << "        </DataArray>\n"
+      << "        <DataArray type=\"Int64\" Name=\"offsets\" format=\"ascii\">\n";
+  ASCII_FORMAT::write_chunked
+    (ofs, n, [] (std::string &buf, std::size_t ii) {
+      ASCII_FORMAT::append (buf, ii + 1);
+      buf += '\n';
+    });
+  ofs << "        </DataArray>\n"
+      << "      </Verts>\n"
+      << "    </Piece>\n"
+      << "  </PolyData>\n"
+      << "</VTKFile>\n";
+  ofs.close ();
+  ++files_written;
+}
+
+
+void
+vtk_series_t::append_to_collection (double time,
+				    const std::vector<part_t *> &written) {
+  pvd.seekp (footer_pos);
+  for (auto const & ii : written)
+    pvd << "    <DataSet timestep=\"" << std::setprecision (16) << time
+	<< "\" group=\"\" part=\"" << ii->index
+	<< "\" file=\"" << ii->file << "\"/>\n";
+  footer_pos = pvd.tellp ();
+  pvd << "  </Collection>\n</VTKFile>\n";
+  pvd.flush ();
+}
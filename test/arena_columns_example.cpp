@@ -0,0 +1,85 @@
+#include <arena_resource.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+// columns start on 64 byte boundaries, are padded and follow
+// one another in memory
+bool
+check_columns (const particles_t &p, const arena_resource_t &arena) {
+  std::vector<std::pair<std::uintptr_t, std::size_t>> cols;
+  cols.emplace_back (reinterpret_cast<std::uintptr_t> (p.x.data ()),
+		     p.x.capacity () * sizeof (double));
+  cols.emplace_back (reinterpret_cast<std::uintptr_t> (p.y.data ()),
+		     p.y.capacity () * sizeof (double));
+  for (auto const & ii : p.dprops)
+    cols.emplace_back (reinterpret_cast<std::uintptr_t> (ii.second.data ()),
+		       ii.second.capacity () * sizeof (double));
+  for (auto const & ii : p.iprops)
+    cols.emplace_back (reinterpret_cast<std::uintptr_t> (ii.second.data ()),
+		       ii.second.capacity () * sizeof (idx_t));
+  std::sort (cols.begin (), cols.end ());
+
+  bool ok = true;
+  for (std::size_t ii = 0; ii < cols.size (); ++ii) {
+    ok = ok && cols[ii].first % arena.alignment () == 0
+      && cols[ii].second % particles_t::column_padding == 0;
+    if (ii > 0)
+      ok = ok && cols[ii].first == cols[ii-1].first + cols[ii-1].second;
+  }
+  return ok;
+}
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (64, 64, 1./64., 1./64.);
+
+  constexpr idx_t num_particles = 100001;
+  arena_resource_t arena (std::size_t (16) << 20, 64, argc > 1);
+  particles_t heap (num_particles, {"label"}, {"m", "vx"}, grid);
+  particles_t ptcls (num_particles, {"label"}, {"m", "vx"}, grid, &arena);
+
+  bool ok = check_columns (ptcls, arena);
+
+  // grow, all columns move together
+  ptcls.reserve (3 * num_particles);
+  ok = ok && check_columns (ptcls, arena);
+  std::cout << "columns in " << arena.num_chunks () << " chunks, "
+	    << arena.bytes_allocated () / 1024 << " KiB allocated" << std::endl;
+
+  for (auto p : {&heap, &ptcls}) {
+    p->dprops["m"].assign (num_particles, 1. / num_particles);
+    for (idx_t ii = 0; ii < num_particles; ++ii)
+      p->dp ("vx", ii) = p->x[ii] * p->y[ii];
+    p->build_mass ();
+  }
+
+  std::map<std::string, std::vector<double>> vh, va;
+  for (auto v : {&vh, &va})
+    for (auto const & name : {"m", "vx"})
+      (*v)[name].assign (grid.num_global_nodes (), 0.);
+
+  heap.p2g (vh, {"m", "vx"}, {"m", "vx"}, true);
+  ptcls.p2g (va, {"m", "vx"}, {"m", "vx"}, true);
+  ok = ok && vh == va;
+
+  // seeding replaces all particles
+  ptcls.seed_cells (8, 8);
+  ok = ok && check_columns (ptcls, arena)
+    && ptcls.dprops["m"].size () == ptcls.x.size ();
+
+  std::cout << (ok ? "arena columns are aligned, padded and adjacent"
+		: "arena columns are not laid out as expected") << std::endl;
+  return ok ? 0 : 1;
+};
@@ -0,0 +1,74 @@
+#include <async_writer.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <tracer.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  // record a timeline if compiled with -DQUADGRID_TRACE
+  tracer_t::instance ().enable ();
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (32, 32, 1./32., 1./32.);
+
+  constexpr idx_t num_particles = 200000;
+  particles_t ptcls (num_particles, {"label"}, {"m", "vx", "vy"}, grid);
+  ptcls.dprops["m"].assign (num_particles, 1. / num_particles);
+  ptcls.dprops["vx"].assign (num_particles, 1.);
+
+  std::map<std::string, std::vector<double>>
+    vars{{"m", std::vector<double>(grid.num_global_nodes (), 0.)},
+	 {"vx", std::vector<double>(grid.num_global_nodes (), 0.)}};
+
+  // at most two snapshots waiting to be written
+  async_writer_t writer (2);
+
+  for (idx_t step = 0; step < 4; ++step) {
+
+    for (auto & ii : vars)
+      std::fill (ii.second.begin (), ii.second.end (), 0.);
+    ptcls.p2g (vars, {"m", "vx"}, {"m", "vx"});
+
+    const std::string suffix = "_" + std::to_string (step);
+    writer.vtk_export (grid, "async_grid" + suffix + ".vts", vars);
+    writer.octave_ascii_export (grid, "async_grid" + suffix + ".octtxt",
+				vars, {"m"});
+    writer.print<particles_t::output_format::csv>
+      (ptcls, "async_particles" + suffix + ".csv", {"m"});
+
+    // the snapshots are taken, data can be modified while writing
+    for (auto & v : ptcls.dprops["vx"])
+      v *= 2.;
+  }
+
+  // all columns, the same as writing synchronously
+  writer.print<particles_t::output_format::csv> (ptcls, "async_particles_all.csv");
+
+  writer.flush ();
+  std::cout << "all output written, " << writer.pending ()
+	    << " jobs pending" << std::endl;
+
+  std::ostringstream direct, async;
+  ptcls.print<particles_t::output_format::csv> (direct);
+  async << std::ifstream ("async_particles_all.csv").rdbuf ();
+  const bool ok = direct.str () == async.str ();
+  std::cout << (ok ? "asynchronous output matches"
+		: "asynchronous output differs") << std::endl;
+
+#ifdef QUADGRID_TRACE
+  std::cout << "timeline written to "
+	    << tracer_t::instance ().write ("async_trace") << std::endl;
+#endif
+
+  return ok ? 0 : 1;
+};
@@ -0,0 +1,109 @@
+#include "benchmark.h"
+
+#include <cstring>
+#include <iostream>
+
+//
+// Benchmark of particle/grid transfers, binning and I/O.
+//
+// Usage : benchmark [--quick] [--output FILE] [--reps N]
+//                   [--grids N1,N2,...] [--ppc P1,P2,...]
+//                   [--max-export-particles N] [--max-slow-particles N]
+//
+// Sweeps square grids of the given sizes, densities in particles per
+// cell and uniform or clustered particle distributions, results are
+// written as json (default file name "benchmark.json") together with
+// the memory report of particles and grid fields of each scenario.
+//
+
+using namespace BENCHMARK;
+
+int
+main (int argc, char *argv[]) {
+
+  std::string output = "benchmark.json";
+  std::vector<idx_t> grids = {32, 128, 512};
+  std::vector<idx_t> ppcs = {4, 16, 64};
+  std::vector<std::string> distributions = {"uniform", "clustered"};
+  int reps = 5;
+  idx_t max_export_particles = 2000000;
+  idx_t max_slow_particles = 100000;
+
+  for (int ii = 1; ii < argc; ++ii) {
+    if (! std::strcmp (argv[ii], "--quick")) {
+      grids = {32, 128};
+      ppcs = {4, 16};
+      reps = 3;
+    }
+    else if (! std::strcmp (argv[ii], "--output") && ii + 1 < argc)
+      output = argv[++ii];
+    else if (! std::strcmp (argv[ii], "--reps") && ii + 1 < argc)
+      reps = std::stoi (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--grids") && ii + 1 < argc)
+      grids = parse_list (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--ppc") && ii + 1 < argc)
+      ppcs = parse_list (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--max-export-particles") && ii + 1 < argc)
+      max_export_particles = std::stoi (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--max-slow-particles") && ii + 1 < argc)
+      max_slow_particles = std::stoi (argv[++ii]);
+    else {
+      std::cerr << "usage : " << argv[0] << " [--quick] [--output FILE]"
+		<< " [--reps N] [--grids N1,N2,...] [--ppc P1,P2,...]"
+		<< " [--max-export-particles N] [--max-slow-particles N]"
+		<< std::endl;
+      return std::strcmp (argv[ii], "--help") ? 1 : 0;
+    }
+  }
+
+  nlohmann::json results = nlohmann::json::array ();
+  nlohmann::json memory = nlohmann::json::array ();
+  const auto ops = operations ();
+
+  for (auto n : grids)
+    for (auto ppc : ppcs)
+      for (auto const & dist : distributions) {
+
+	const scenario_t s {n, n, ppc, dist};
+	fixture_t f (s);
+	std::cerr << "scenario " << s.name () << " ("
+		  << s.num_particles () << " particles)" << std::endl;
+
+	memory.push_back ({{"scenario", s},
+			   {"particles", f.ptcls->memory_report ()},
+			   {"grid", f.grid->memory_report (f.vars)}});
+
+	for (auto const & op : ops) {
+
+	  if ((op.is_export && s.num_particles () > max_export_particles)
+	      || (op.is_slow && s.num_particles () > max_slow_particles))
+	    continue;
+
+	  auto t = time_operation (op, f, 1, reps);
+	  const double tmed = median (t);
+	  results.push_back
+	    ({{"scenario", s},
+	      {"operation", op.name},
+	      {"repetitions", reps},
+	      {"seconds_median", tmed},
+	      {"seconds_min", *std::min_element (t.begin (), t.end ())},
+	      {"seconds_mad", mad (t)},
+	      {"particles_per_second", s.num_particles () / tmed},
+	      {"nodes_per_second", f.grid->num_global_nodes () / tmed}});
+
+	  std::cerr << "  " << op.name << " " << tmed << " s, "
+		    << s.num_particles () / tmed << " particles/s"
+		    << std::endl;
+	}
+      }
+
+  cleanup ();
+
+  std::ofstream os (output);
+  os << std::setw (2) << nlohmann::json {{"benchmark", "quadgrid"},
+					 {"results", results},
+					 {"memory", memory}};
+  os.close ();
+
+  return 0;
+};
@@ -0,0 +1,283 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <checkpoint.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <vtk_series.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//! @brief Scenarios and timing utilities shared by the benchmark
+//! programs `benchmark.cpp` and `benchmark_regression.cpp`.
+namespace BENCHMARK {
+
+  using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+  //! A benchmark scenario: grid size, particles per cell, distribution.
+  struct
+  scenario_t {
+    idx_t        numrows;
+    idx_t        numcols;
+    idx_t        ppc;           //!< average number of particles per cell.
+    std::string  distribution;  //!< either "uniform" or "clustered".
+
+    idx_t
+    num_particles () const
+    { return numrows * numcols * ppc; };
+
+    std::string
+    name () const {
+      return std::to_string (numrows) + "x" + std::to_string (numcols)
+	+ "_ppc" + std::to_string (ppc) + "_" + distribution;
+    };
+  };
+
+  inline void
+  to_json (nlohmann::json &j, const scenario_t &s) {
+    j = nlohmann::json{{"name", s.name ()},
+		       {"numrows", s.numrows},
+		       {"numcols", s.numcols},
+		       {"ppc", s.ppc},
+		       {"distribution", s.distribution},
+		       {"num_particles", s.num_particles ()}};
+  }
+
+  //! Grid, particles and grid fields set up for a scenario.
+  struct
+  fixture_t {
+
+    std::unique_ptr<quadgrid_t<std::vector<double>>>  grid;
+    std::unique_ptr<particles_t>                      ptcls;
+    std::map<std::string, std::vector<double>>        vars;
+    scenario_t                                        scenario;
+    //! copy of the particles for destructive operations.
+    std::unique_ptr<particles_t>                      backup;
+
+    explicit
+    fixture_t (const scenario_t &s) : scenario (s) {
+
+      grid = std::make_unique<quadgrid_t<std::vector<double>>> ();
+      grid->set_sizes (s.numrows, s.numcols, 1. / s.numcols, 1. / s.numrows);
+
+      // fixed seed, so that all runs see the same particles
+      std::mt19937 gen (42);
+      std::uniform_real_distribution<> uni (0.0, 1.0);
+      std::normal_distribution<> blob (0.5, 0.08);
+      const bool clustered = s.distribution == "clustered";
+      auto coord = [&] () {
+	double v = clustered ? blob (gen) : uni (gen);
+	return std::min (std::max (v, 0.0), 1.0 - 1.0e-12);
+      };
+
+      ptcls = std::make_unique<particles_t>
+	(s.num_particles (), std::vector<std::string>{"label"},
+	 std::vector<std::string>{"m", "vx", "vy", "area", "p"},
+	 *grid, coord, coord);
+
+      ptcls->dprops["m"].assign (ptcls->num_particles,
+				 1. / ptcls->num_particles);
+      ptcls->dprops["vx"].assign (ptcls->num_particles, 1.);
+      ptcls->dprops["vy"].assign (ptcls->num_particles, -1.);
+      ptcls->dprops["area"].assign (ptcls->num_particles,
+				    1. / ptcls->num_particles);
+      std::iota (ptcls->iprops["label"].begin (),
+		 ptcls->iprops["label"].end (), 0);
+
+      for (auto const & name : {"m", "vx", "vy", "div", "p"})
+	vars[name].assign (grid->num_global_nodes (), 0.);
+      ptcls->build_mass ();
+    };
+  };
+
+  //! A benchmarked operation.
+  struct
+  operation_t {
+    std::string                        name;
+    std::function<void (fixture_t &)>  run;
+    //! untimed preparation before each repetition, may be empty.
+    std::function<void (fixture_t &)>  prepare;
+    //! operation writes files (skipped for very large scenarios).
+    bool                               is_export;
+    //! operation cost grows faster than linearly with particles.
+    bool                               is_slow;
+  };
+
+  //! @brief All operations measured by the benchmarks.
+  inline std::vector<operation_t>
+  operations () {
+
+    static const std::string tmp = "benchmark_tmp_output";
+    auto nop = std::function<void (fixture_t &)> {};
+    std::vector<operation_t> ops;
+
+    ops.push_back ({"init_particle_mesh",
+		    [] (fixture_t &f) { f.ptcls->init_particle_mesh (); },
+		    nop, false, false});
+
+    ops.push_back ({"p2g",
+		    [] (fixture_t &f) {
+		      f.ptcls->p2g (f.vars, {"m", "vx", "vy"},
+				    {"m", "vx", "vy"}); },
+		    nop, false, false});
+
+    ops.push_back ({"p2g_mass",
+		    [] (fixture_t &f) {
+		      f.ptcls->p2g (f.vars, {"vx", "vy"},
+				    {"vx", "vy"}, true); },
+		    nop, false, false});
+
+    ops.push_back ({"p2gd",
+		    [] (fixture_t &f) {
+		      f.ptcls->p2gd (f.vars, {"vx"}, {"vy"},
+				     "area", {"div"}); },
+		    nop, false, false});
+
+    ops.push_back ({"g2p",
+		    [] (fixture_t &f) {
+		      f.ptcls->g2p (f.vars, {"vx", "vy"},
+				    {"vx", "vy"}, false,
+				    ASSIGNMENT_OPS::EQ); },
+		    nop, false, false});
+
+    ops.push_back ({"g2pd",
+		    [] (fixture_t &f) {
+		      f.ptcls->g2pd (f.vars, {"p"}, {"vx"}, {"vy"}); },
+		    nop, false, false});
+
+    ops.push_back ({"build_mass",
+		    [] (fixture_t &f) { f.ptcls->build_mass (); },
+		    nop, false, false});
+
+    // removal is destructive, each repetition works on a fresh copy
+    ops.push_back ({"remove_in_region",
+		    [] (fixture_t &f) {
+		      f.ptcls->remove_in_region ([] (double x, double y) {
+			return (x-.5)*(x-.5) + (y-.5)*(y-.5) < .05*.05; });
+		    },
+		    [] (fixture_t &f) {
+		      if (! f.backup)
+			f.backup = std::make_unique<particles_t> (*f.ptcls);
+		      else
+			f.ptcls = std::make_unique<particles_t> (*f.backup);
+		    }, false, true});
+
+    ops.push_back ({"print_csv",
+		    [] (fixture_t &f) {
+		      std::ofstream os (tmp);
+		      f.ptcls->print<particles_t::output_format::csv> (os); },
+		    nop, true, false});
+
+    ops.push_back ({"print_octave_ascii",
+		    [] (fixture_t &f) {
+		      std::ofstream os (tmp);
+		      f.ptcls->print<particles_t::output_format::octave_ascii> (os); },
+		    nop, true, false});
+
+    ops.push_back ({"print_json",
+		    [] (fixture_t &f) {
+		      std::ofstream os (tmp);
+		      f.ptcls->print<particles_t::output_format::json> (os); },
+		    nop, true, false});
+
+    ops.push_back ({"checkpoint_write",
+		    [] (fixture_t &f) {
+		      checkpoint_t::write (tmp.c_str (), *f.ptcls, f.vars); },
+		    nop, true, false});
+
+    ops.push_back ({"vtk_export",
+		    [] (fixture_t &f) {
+		      f.grid->vtk_export (tmp.c_str (), f.vars); },
+		    nop, true, false});
+
+    ops.push_back ({"octave_ascii_export",
+		    [] (fixture_t &f) {
+		      f.grid->octave_ascii_export (tmp.c_str (), f.vars); },
+		    nop, true, false});
+
+    ops.push_back ({"vtk_series_step",
+		    [] (fixture_t &f) {
+		      vtk_series_t series (tmp, *f.grid);
+		      series.write_step (0., f.vars, *f.ptcls); },
+		    nop, true, false});
+
+    return ops;
+  }
+
+  //! @brief Remove temporary files written by export operations.
+  inline void
+  cleanup () {
+    for (auto const & f : {"benchmark_tmp_output",
+			   "benchmark_tmp_output.pvd"})
+      std::remove (f);
+    for (auto const & f : {"m", "vx", "vy", "div", "p"})
+      std::remove ((std::string ("benchmark_tmp_output_") + f
+		    + "_0.vti").c_str ());
+    std::remove ("benchmark_tmp_output_particles_0.vtp");
+  }
+
+  //! @brief Time `reps` runs of `op` after `warmup` untimed runs.
+  inline std::vector<double>
+  time_operation (const operation_t &op, fixture_t &f,
+		  int warmup, int reps) {
+    std::vector<double> t;
+    for (int ii = 0; ii < warmup + reps; ++ii) {
+      if (op.prepare)
+	op.prepare (f);
+      auto start = std::chrono::steady_clock::now ();
+      op.run (f);
+      auto stop = std::chrono::steady_clock::now ();
+      if (ii >= warmup)
+	t.push_back (std::chrono::duration<double> (stop - start).count ());
+    }
+    if (op.prepare)
+      op.prepare (f);
+    return t;
+  }
+
+  //! median of a sample.
+  inline double
+  median (std::vector<double> v) {
+    if (v.empty ())
+      return 0.;
+    std::sort (v.begin (), v.end ());
+    const std::size_t n = v.size ();
+    return n % 2 ? v[n/2] : .5 * (v[n/2-1] + v[n/2]);
+  }
+
+  //! median absolute deviation of a sample.
+  inline double
+  mad (const std::vector<double> &v) {
+    const double m = median (v);
+    std::vector<double> d (v.size ());
+    std::transform (v.begin (), v.end (), d.begin (),
+		    [m] (double x) { return std::abs (x - m); });
+    return median (d);
+  }
+
+  //! @brief Parse a comma separated list of integers.
+  inline std::vector<idx_t>
+  parse_list (const std::string &s) {
+    std::vector<idx_t> v;
+    std::stringstream ss (s);
+    std::string item;
+    while (std::getline (ss, item, ','))
+      v.push_back (std::stoi (item));
+    return v;
+  }
+
+}
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,164 @@
+#include "benchmark.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+//
+// Performance regression check against a stored baseline.
+//
+// Usage : benchmark_regression [--baseline FILE] [--save FILE]
+//                              [--tolerance T] [--mad-factor K]
+//                              [--warmup N] [--reps N] [--retries N]
+//
+// Times a fixed set of binning, transfer and export operations on a
+// fixed set of scenarios. With --save the results are stored as a new
+// baseline, with --baseline they are compared against a baseline
+// (written by --save or by the benchmark program). An operation
+// regresses if its median time exceeds
+//
+//   baseline_median * (1 + T) + K * (baseline_mad + mad)
+//
+// so that timing noise measured by the median absolute deviation does
+// not produce false alarms; an operation exceeding the threshold is
+// timed again up to N more times (--retries) and reported only if it
+// exceeds the threshold in all attempts, which filters out transient
+// load on the machine. The exit status is 1 if any operation
+// regressed, 0 otherwise.
+//
+// Build (see README.md):
+//
+//   mpicxx -std=c++17 -O3 -I../include -o benchmark_regression benchmark_regression.cpp ../src/*.cpp
+//
+
+using namespace BENCHMARK;
+
+int
+main (int argc, char *argv[]) {
+
+  std::string baseline_file, save_file;
+  double tolerance = 0.10;
+  double mad_factor = 3.0;
+  int warmup = 2;
+  int reps = 9;
+  int retries = 2;
+
+  for (int ii = 1; ii < argc; ++ii) {
+    if (! std::strcmp (argv[ii], "--baseline") && ii + 1 < argc)
+      baseline_file = argv[++ii];
+    else if (! std::strcmp (argv[ii], "--save") && ii + 1 < argc)
+      save_file = argv[++ii];
+    else if (! std::strcmp (argv[ii], "--tolerance") && ii + 1 < argc)
+      tolerance = std::stod (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--mad-factor") && ii + 1 < argc)
+      mad_factor = std::stod (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--warmup") && ii + 1 < argc)
+      warmup = std::stoi (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--reps") && ii + 1 < argc)
+      reps = std::stoi (argv[++ii]);
+    else if (! std::strcmp (argv[ii], "--retries") && ii + 1 < argc)
+      retries = std::stoi (argv[++ii]);
+    else {
+      std::cerr << "usage : " << argv[0] << " [--baseline FILE]"
+		<< " [--save FILE] [--tolerance T] [--mad-factor K]"
+		<< " [--warmup N] [--reps N] [--retries N]" << std::endl;
+      return std::strcmp (argv[ii], "--help") ? 1 : 0;
+    }
+  }
+
+  // baseline entries indexed by scenario and operation name
+  std::map<std::pair<std::string, std::string>, nlohmann::json> baseline;
+  if (! baseline_file.empty ()) {
+    std::ifstream is (baseline_file);
+    if (! is) {
+      std::cerr << "cannot open baseline " << baseline_file << std::endl;
+      return 2;
+    }
+    nlohmann::json j;
+    is >> j;
+    for (auto const & r : j["results"])
+      baseline[{r["scenario"]["name"].get<std::string> (),
+		r["operation"].get<std::string> ()}] = r;
+  }
+
+  const std::vector<scenario_t> scenarios = {
+    {64, 64, 16, "uniform"},
+    {128, 128, 8, "clustered"}
+  };
+
+  const std::set<std::string> selected = {
+    "init_particle_mesh", "p2g", "p2gd", "g2p", "g2pd",
+    "print_csv", "checkpoint_write", "vtk_export"
+  };
+
+  nlohmann::json results = nlohmann::json::array ();
+  int regressions = 0;
+
+  for (auto const & s : scenarios) {
+
+    fixture_t f (s);
+    std::cout << "scenario " << s.name () << std::endl;
+
+    for (auto const & op : operations ()) {
+
+      if (selected.count (op.name) == 0)
+	continue;
+
+      auto b = baseline.find ({s.name (), op.name});
+      const bool in_baseline = b != baseline.end ();
+      double bmed = 0., bmad = 0.;
+      if (in_baseline) {
+	bmed = b->second["seconds_median"].get<double> ();
+	bmad = b->second.value ("seconds_mad", 0.);
+      }
+
+      double tmed = 0., tmad = 0.;
+      bool regressed = false;
+      for (int attempt = 0; attempt <= retries; ++attempt) {
+	auto t = time_operation (op, f, warmup, reps);
+	tmed = median (t);
+	tmad = mad (t);
+	regressed = in_baseline
+	  && tmed > bmed * (1. + tolerance) + mad_factor * (bmad + tmad);
+	if (! regressed)
+	  break;
+      }
+      regressions += regressed;
+
+      results.push_back ({{"scenario", s},
+			  {"operation", op.name},
+			  {"repetitions", reps},
+			  {"seconds_median", tmed},
+			  {"seconds_mad", tmad}});
+
+      std::cout << "  " << std::left << std::setw (20) << op.name
+		<< std::right << std::scientific << std::setprecision (3)
+		<< std::setw (12) << tmed << " s";
+      if (in_baseline)
+	std::cout << std::fixed << std::setprecision (1)
+		  << "  baseline " << std::setw (6)
+		  << 100. * (tmed - bmed) / bmed << " %"
+		  << (regressed ? "  REGRESSION" : "");
+      else if (! baseline_file.empty ())
+	std::cout << "  (not in baseline)";
+      std::cout << std::endl;
+    }
+  }
+
+  cleanup ();
+
+  if (! save_file.empty ()) {
+    std::ofstream os (save_file);
+    os << std::setw (2) << nlohmann::json {{"benchmark", "quadgrid"},
+					   {"results", results}};
+    os.close ();
+    std::cout << "baseline saved to " << save_file << std::endl;
+  }
+
+  if (regressions > 0) {
+    std::cout << regressions << " operation(s) regressed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
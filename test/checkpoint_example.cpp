@@ -0,0 +1,102 @@
+#include <checkpoint.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (16, 32, 1./32., 1./16.);
+
+  constexpr idx_t num_particles = 100000;
+  particles_t ptcls (num_particles, {"label"}, {"m", "vx", "vy"}, grid);
+  ptcls.dprops["m"].assign (num_particles, 1. / num_particles);
+  std::iota (ptcls.dprops["vx"].begin (), ptcls.dprops["vx"].end (), 0.);
+  std::iota (ptcls.iprops["label"].begin (), ptcls.iprops["label"].end (), 0);
+
+  std::map<std::string, std::vector<double>>
+    vars{{"m", std::vector<double>(grid.num_global_nodes (), 0.)}};
+  ptcls.p2g (vars, {"m"}, {"m"});
+
+  checkpoint_t::write ("checkpoint_example.bin", ptcls, vars);
+
+  // restart : set up the grid from the header, then copy the columns
+  checkpoint_t ckpt ("checkpoint_example.bin");
+  quadgrid_t<std::vector<double>> grid2;
+  ckpt.set_grid (grid2);
+  particles_t ptcls2 (ckpt, grid2);
+  auto vars2 = ckpt.grid_vars ();
+
+  // zero-copy access to a single column
+  const double *vx = ckpt.data<double> (checkpoint_t::column_kind::dprop, "vx");
+
+  bool ok = grid2.num_rows () == grid.num_rows ()
+    && grid2.num_cols () == grid.num_cols ()
+    && grid2.hx () == grid.hx () && grid2.hy () == grid.hy ()
+    && ptcls2.num_particles == ptcls.num_particles
+    && ptcls2.x == ptcls.x && ptcls2.y == ptcls.y
+    && ptcls2.dprops == ptcls.dprops && ptcls2.iprops == ptcls.iprops
+    && ptcls2.grd_to_ptcl == ptcls.grd_to_ptcl
+    && vars2 == vars
+    && std::equal (vx, vx + num_particles, ptcls.dprops["vx"].begin ());
+
+  // corrupt copies of the file: a column shorter than the others,
+  // an element size of zero, a count that overflows the bounds check
+  std::ifstream ifs ("checkpoint_example.bin", std::ifstream::binary);
+  const std::vector<char> bytes ((std::istreambuf_iterator<char> (ifs)),
+				 std::istreambuf_iterator<char> ());
+  const std::size_t first = sizeof (checkpoint_t::header_t);
+  const std::size_t entry = sizeof (checkpoint_t::entry_t);
+  auto corrupt = [&] (std::size_t icol, std::size_t field,
+		      const void *value, std::size_t size) {
+    std::vector<char> b (bytes);
+    std::memcpy (b.data () + first + icol * entry + field, value, size);
+    std::ofstream ofs ("checkpoint_corrupt.bin", std::ofstream::binary);
+    ofs.write (b.data (), b.size ());
+  };
+
+  const std::uint64_t shorter = num_particles - 1;
+  corrupt (2, offsetof (checkpoint_t::entry_t, count),
+	   &shorter, sizeof (shorter));
+  try {
+    checkpoint_t bad ("checkpoint_corrupt.bin");
+    particles_t ptcls3 (bad, grid2);
+    ok = false;
+  }
+  catch (const std::runtime_error &) { }
+
+  const std::uint32_t zero = 0;
+  corrupt (2, offsetof (checkpoint_t::entry_t, elem_size),
+	   &zero, sizeof (zero));
+  try {
+    checkpoint_t bad ("checkpoint_corrupt.bin");
+    ok = false;
+  }
+  catch (const std::runtime_error &) { }
+
+  const std::uint64_t huge = std::uint64_t (1) << 61;
+  corrupt (2, offsetof (checkpoint_t::entry_t, count), &huge, sizeof (huge));
+  try {
+    checkpoint_t bad ("checkpoint_corrupt.bin");
+    ok = false;
+  }
+  catch (const std::runtime_error &) { }
+
+  std::cout << "checkpoint has " << ckpt.columns ().size () << " columns, "
+	    << "restart " << (ok ? "matches" : "DOES NOT match")
+	    << " the original data" << std::endl;
+
+  return ok ? 0 : 1;
+};
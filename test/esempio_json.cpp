@@ -52,6 +52,19 @@ main () {
     jf << std::setw(2) << j;
     jf.close ();
   }
+
+  {
+    // stream the same file without building a json object
+    std::ifstream is ("esempio.json");
+    std::map<std::string, std::vector<double>> svars;
+    particles_t sp (is, qg, &svars);
+    if (sp.x != p.x || sp.y != p.y || sp.dprops != p.dprops
+	|| sp.iprops != p.iprops || sp.grd_to_ptcl.size () == 0
+	|| svars != vars) {
+      std::cerr << "streamed data differ from json data" << std::endl;
+      return 1;
+    }
+  }
   
   return 0;
 }
@@ -0,0 +1,120 @@
+#include <field_registry.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (64, 64, 1./64., 1./64.);
+
+  // particles in a small disc, moving across the grid
+  particles_t ptcls (0, {}, {"m", "vx", "vy"}, grid);
+  auto disc = [] (double x, double y) {
+    return (x - .25) * (x - .25) + (y - .25) * (y - .25) < .1 * .1;
+  };
+  ptcls.seed_cells (4, 4, particles_t::seeding_t::jittered, disc);
+  ptcls.build_mass ();
+
+  field_registry_t fields (grid);
+  const field_registry_t & cfields = fields;
+  const auto hm = fields.add ("m");
+  const auto hv = fields.add ("vx");
+
+  bool ok = fields.handle ("vx").id == hv.id;
+  try {
+    fields.handle ("vy");
+    ok = false;
+  }
+  catch (const std::out_of_range &) { }
+
+  std::map<std::string, std::vector<double>> vars;
+  for (int step = 0; step < 10; ++step) {
+    for (idx_t ii = 0; ii < ptcls.num_particles; ++ii) {
+      ptcls.dp ("m", ii) = 1. + ptcls.x[ii];
+      ptcls.dp ("vx", ii) = std::sin (ptcls.y[ii] + step);
+    }
+
+    // dense fields, zeroed by hand
+    for (auto const & name : {"m", "vx"})
+      vars[name].assign (grid.num_global_nodes (), 0.);
+    ptcls.p2g (vars, {"m", "vx"}, {"m", "vx"}, step % 2 == 1);
+
+    // registry fields, zeroed in the scatter; read only through
+    // the const registry so that zeroing stays fused into p2g and
+    // nodes left behind by the particles are cleared from the
+    // cells written in earlier steps
+    fields.zero ({hm, hv});
+    ptcls.p2g (fields, {"m", "vx"}, {hm, hv}, step % 2 == 1);
+    ok = ok && ! fields.zero_pending (hm)
+      && std::equal (vars["m"].begin (), vars["m"].end (), cfields[hm].begin ())
+      && std::equal (vars["vx"].begin (), vars["vx"].end (), cfields.values (hv).begin ());
+
+    particles_t::dcolumn_t back = ptcls.dprops["vx"];
+    ptcls.g2p (vars, {"vx"}, {"vx"}, false, ASSIGNMENT_OPS::EQ);
+    ptcls.dprops["vx"].swap (back);
+    ptcls.g2p (fields, {hv}, {"vx"}, false, ASSIGNMENT_OPS::EQ);
+    ok = ok && std::equal (back.begin (), back.end (), ptcls.dprops["vx"].begin ());
+
+    for (idx_t ii = 0; ii < ptcls.num_particles; ++ii) {
+      ptcls.x[ii] += .05;
+      ptcls.y[ii] += .03;
+    }
+    ptcls.init_particle_mesh ();
+  }
+
+  // velocity as one field with two interleaved components
+  const auto hvel = fields.add ("v", 2);
+  ptcls.dprops["vy"].assign (ptcls.num_particles, 0.);
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii)
+    ptcls.dp ("vy", ii) = std::cos (ptcls.x[ii]);
+  for (auto const & name : {"vx", "vy"})
+    vars[name].assign (grid.num_global_nodes (), 0.);
+  ptcls.p2g (vars, {"vx", "vy"}, {"vx", "vy"}, true);
+  fields.zero ({hvel});
+  ptcls.p2g (fields, {"vx", "vy"}, {hvel}, true);
+  auto const & vel = cfields.values (hvel);
+  for (idx_t ii = 0; ii < grid.num_global_nodes (); ++ii)
+    ok = ok && vel[2 * ii] == vars["vx"][ii] && vel[2 * ii + 1] == vars["vy"][ii];
+
+  particles_t::dcolumn_t gx = ptcls.dprops["vx"], gy = ptcls.dprops["vy"];
+  ptcls.g2p (vars, {"vx", "vy"}, {"vx", "vy"}, true, ASSIGNMENT_OPS::EQ);
+  ptcls.dprops["vx"].swap (gx);
+  ptcls.dprops["vy"].swap (gy);
+  ptcls.g2p (fields, {hvel}, {"vx", "vy"}, true, ASSIGNMENT_OPS::EQ);
+  ok = ok && gx == ptcls.dprops["vx"] && gy == ptcls.dprops["vy"];
+
+  try {
+    fields.add ("v", 3);
+    ok = false;
+  }
+  catch (const std::invalid_argument &) { }
+
+  // one name per component
+  for (auto const & names : {std::vector<std::string> {"vx"},
+			     std::vector<std::string> {"vx", "vy", "m"}})
+    try {
+      ptcls.p2g (fields, names, {hvel});
+      ok = false;
+    }
+    catch (const std::invalid_argument &) { }
+
+  // fields written directly are cleared in full
+  fields[hm][0] = 1.;
+  fields.zero ({hm});
+  ok = ok && fields.zero_pending (hm) && fields[hm][0] == 0.;
+
+  std::cout << (ok ? "registry and dense fields agree"
+		: "registry and dense fields differ") << std::endl;
+  return ok ? 0 : 1;
+};
@@ -0,0 +1,101 @@
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using grid_t = quadgrid_t<std::vector<double>>;
+using idx_t = grid_t::idx_t;
+
+static constexpr idx_t numrows = 40;
+static constexpr idx_t numcols = 24;
+static constexpr idx_t num_particles = 200000;
+
+// particle masses mapped to the grid, indexed by column-major position
+static std::vector<double>
+column_major_p2g (grid_t::ordering_t o, bool &ok) {
+
+  grid_t grid;
+  grid.set_sizes (numrows, numcols, 1./numcols, 1./numrows);
+  grid.set_ordering (o);
+
+  // each cell is visited once, in index order
+  idx_t expected = 0;
+  for (auto icell = grid.begin_cell_sweep ();
+       icell != grid.end_cell_sweep (); ++icell, ++expected) {
+    const idx_t idx = icell->get_global_cell_idx ();
+    const idx_t r = icell->row_idx (), c = icell->col_idx ();
+    ok = ok && idx == expected && grid.sub2gind (r, c) == idx
+      && grid.gind2row (idx) == r && grid.gind2col (idx) == c;
+    for (idx_t k = 0; k < 4; ++k) {
+      const idx_t n = icell->gt (k);
+      ok = ok && grid.node_gind2row (n) == r + k % 2
+	&& grid.node_gind2col (n) == c + k / 2;
+    }
+  }
+  ok = ok && expected == grid.num_global_cells ();
+
+  std::mt19937 gen (3);
+  std::uniform_real_distribution<> dis (0.0, 1.0);
+  auto coord = [&] () { return dis (gen); };
+  particles_t ptcls (num_particles, {}, {"m"}, grid, coord, coord);
+  ptcls.dprops["m"].assign (num_particles, 1. / num_particles);
+
+  std::map<std::string, std::vector<double>>
+    vars{{"m", std::vector<double> (grid.num_global_nodes (), 0.)}};
+  ptcls.p2g (vars);
+
+  const std::string name = std::string ("grid_ordering_")
+    + grid_t::ordering_name (o) + ".vts";
+  grid.vtk_export (name.c_str (), vars);
+
+  std::vector<double> out (grid.num_global_nodes ());
+  for (idx_t c = 0; c <= numcols; ++c)
+    for (idx_t r = 0; r <= numrows; ++r)
+      out[r + (numrows + 1) * c] = vars["m"][grid.node_sub2gind (r, c)];
+  return out;
+}
+
+int
+main (int argc, char *argv[]) {
+
+  bool ok = true;
+  const auto ref = column_major_p2g (grid_t::ordering_t::column_major, ok);
+
+  for (auto o : {grid_t::ordering_t::morton, grid_t::ordering_t::hilbert}) {
+    // particles are placed with the same seed, only the order of
+    // accumulation differs
+    const auto v = column_major_p2g (o, ok);
+    double err = 0.;
+    for (std::size_t ii = 0; ii < v.size (); ++ii)
+      err = std::max (err, std::abs (v[ii] - ref[ii]));
+    std::cout << grid_t::ordering_name (o)
+	      << " max difference from column_major " << err << std::endl;
+    ok = ok && err < 1.e-12;
+  }
+
+  // points outside the grid map to out_of_grid with every ordering
+  for (auto o : {grid_t::ordering_t::column_major, grid_t::ordering_t::morton,
+		 grid_t::ordering_t::hilbert}) {
+    grid_t grid;
+    grid.set_sizes (4, 4, .25, .25);
+    grid.set_ordering (o);
+    ok = ok && grid.sub2gind (4, 0) == grid_t::out_of_grid
+      && grid.sub2gind (0, 4) == grid_t::out_of_grid
+      && grid.sub2gind (-1, 2) == grid_t::out_of_grid;
+
+    particles_t ptcls (3, {}, {"m"}, grid);
+    ptcls.x.assign ({.5, 1., -.1});
+    ptcls.y.assign ({.5, .9, .5});
+    ptcls.init_particle_mesh ();
+    ok = ok && ptcls.grd_to_ptcl.at (grid_t::out_of_grid).size () == 2
+      && ptcls.active_cells.size () == 1;
+  }
+
+  std::cout << (ok ? "orderings agree" : "orderings differ") << std::endl;
+  return ok ? 0 : 1;
+};
@@ -0,0 +1,171 @@
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <sparse_field.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (30, 50, .1, .2);
+  grid.set_ordering (quadgrid_t<std::vector<double>>::ordering_t::hilbert);
+
+  // closed form lumped mass against assembly over cells
+  std::vector<double> mass (grid.num_global_nodes (), 0.0);
+  for (auto icell = grid.begin_cell_sweep ();
+       icell != grid.end_cell_sweep (); ++icell)
+    for (auto inode = 0; inode < 4; ++inode)
+      mass[icell->gt (inode)] += (grid.hx () / 2.) * (grid.hy () / 2.);
+  bool ok = mass == grid.lumped_mass ();
+
+  // particle-weighted mass against p2g of the particle mass
+  particles_t ptcls (200000, {}, {"m", "vx"}, grid);
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii) {
+    ptcls.dp ("m", ii) = 1. + ptcls.x[ii] * ptcls.y[ii];
+    ptcls.dp ("vx", ii) = 3.;
+  }
+  ptcls.build_particle_mass ("m");
+
+  std::map<std::string, std::vector<double>> vars;
+  vars["m"].assign (grid.num_global_nodes (), 0.);
+  ptcls.p2g (vars, {"m"}, {"m"});
+  for (std::size_t ii = 0; ii < mass.size (); ++ii)
+    ok = ok && std::abs (vars["m"][ii] - ptcls.mass ()[ii]) <= 1e-12 * ptcls.mass ()[ii];
+
+  // momentum over mass gives back a uniform velocity
+  vars["mvx"].assign (grid.num_global_nodes (), 0.);
+  ptcls.dprops["mvx"].resize (ptcls.num_particles);
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii)
+    ptcls.dp ("mvx", ii) = ptcls.dp ("m", ii) * ptcls.dp ("vx", ii);
+  ptcls.p2g (vars, {"mvx"}, {"mvx"}, true);
+  for (auto v : vars["mvx"])
+    ok = ok && std::abs (v - 3.) < 1e-12;
+
+  auto close = [] (double a, double b) {
+    return std::abs (a - b) <= 1e-14 * std::max (std::abs (a), std::abs (b));
+  };
+  auto const & M = ptcls.mass ();
+
+  // inverse mass applied to two fields in one sweep against
+  // dividing each field by the mass
+  std::map<std::string, std::vector<double>> plain, scaled;
+  for (auto const & name : {"m", "mvx"}) {
+    plain[name].assign (grid.num_global_nodes (), 0.);
+    scaled[name].assign (grid.num_global_nodes (), 0.);
+  }
+  ptcls.p2g (plain, {"m", "mvx"}, {"m", "mvx"});
+  ptcls.p2g (scaled, {"m", "mvx"}, {"m", "mvx"}, true);
+  for (auto const & name : {"m", "mvx"})
+    for (std::size_t ii = 0; ii < M.size (); ++ii)
+      ok = ok && close (scaled[name][ii],
+			M[ii] != 0. ? plain[name][ii] / M[ii] : 0.);
+
+  // mass-weighted nodal values computed once per cell, added to the
+  // particle values, against a sum over the nodes of each particle
+  std::map<std::string, std::vector<double>> g{{"g", {}}};
+  std::map<std::string, sparse_field_t> sg;
+  sg.emplace ("g", sparse_field_t (grid));
+  for (idx_t n = 0; n < grid.num_global_nodes (); ++n) {
+    g["g"].push_back (std::sin (static_cast<double> (n)));
+    sg.at ("g").touch (n) = g["g"].back ();
+  }
+  for (auto const & name : {"a", "ax", "ay", "as"})
+    ptcls.dprops[name].assign (ptcls.num_particles, 1.);
+  ptcls.g2p (g, {"g"}, {"a"}, true);
+  ptcls.g2pd (g, {"g"}, {"ax"}, {"ay"}, true);
+  ptcls.g2p (sg, {"g"}, {"as"}, true);
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii) {
+    const double xx = ptcls.x[ii], yy = ptcls.y[ii];
+    auto const icell = grid.cell (ptcls.cell_index (xx, yy));
+    double a = 1., ax = 1., ay = 1.;
+    for (idx_t inode = 0; inode < 4; ++inode) {
+      const double w = M[icell.gt (inode)] * g["g"][icell.gt (inode)];
+      a += icell.shp (xx, yy, inode) * w;
+      ax += icell.shg (xx, yy, 0, inode) * w;
+      ay += icell.shg (xx, yy, 1, inode) * w;
+    }
+    ok = ok && close (ptcls.dp ("a", ii), a) && close (ptcls.dp ("as", ii), a)
+      && close (ptcls.dp ("ax", ii), ax) && close (ptcls.dp ("ay", ii), ay);
+  }
+
+  // only nodes of active cells are scaled by the inverse mass
+  particles_t one (1, {}, {"m"}, grid);
+  one.x.assign ({.15});
+  one.y.assign ({.3});
+  one.dprops["m"].assign (1, 1.);
+  one.init_particle_mesh ();
+  one.build_mass ();
+  std::map<std::string, std::vector<double>>
+    ones{{"m", std::vector<double> (grid.num_global_nodes (), 1.)}};
+  one.p2g (ones, {"m"}, {"m"}, true);
+  auto const icell = grid.cell (one.cell_index (.15, .3));
+  std::vector<idx_t> scaled_nodes;
+  for (idx_t n = 0; n < grid.num_global_nodes (); ++n)
+    if (ones["m"][n] != 1.)
+      scaled_nodes.push_back (n);
+  std::vector<idx_t> cell_nodes;
+  for (idx_t inode = 0; inode < 4; ++inode)
+    cell_nodes.push_back (icell.gt (inode));
+  std::sort (cell_nodes.begin (), cell_nodes.end ());
+  ok = ok && scaled_nodes == cell_nodes;
+
+  // the mass can only be replaced as a whole, with its inverse
+  std::vector<double> twice (M.size ());
+  for (std::size_t ii = 0; ii < M.size (); ++ii)
+    twice[ii] = 2. * M[ii];
+  ptcls.set_mass (twice);
+  for (std::size_t ii = 0; ii < M.size (); ++ii)
+    ok = ok && close (ptcls.inverse_mass ()[ii],
+		      twice[ii] != 0. ? 1. / twice[ii] : 0.);
+  try {
+    ptcls.set_mass ({1., 2.});
+    ok = false;
+  }
+  catch (const std::invalid_argument &) { }
+
+  // kept until particles are binned again
+  const std::uint64_t version = ptcls.mass_version;
+  ptcls.build_particle_mass ("m");
+  ok = ok && ptcls.mass_version == version;
+  ptcls.init_particle_mesh ();
+  ptcls.build_particle_mass ("m");
+  ok = ok && ptcls.mass_version == version + 1;
+
+  // ... or moved within their cells, or their masses change
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii) {
+    auto const icell = grid.cell (ptcls.cell_index (ptcls.x[ii], ptcls.y[ii]));
+    ptcls.x[ii] = .5 * (ptcls.x[ii] + icell.p (0, 0) + .5 * grid.hx ());
+    ptcls.y[ii] = .5 * (ptcls.y[ii] + icell.p (1, 0) + .5 * grid.hy ());
+  }
+  ptcls.build_particle_mass ("m");
+  vars["m"].assign (grid.num_global_nodes (), 0.);
+  ptcls.p2g (vars, {"m"}, {"m"});
+  for (std::size_t ii = 0; ii < mass.size (); ++ii)
+    ok = ok && close (vars["m"][ii], ptcls.mass ()[ii]);
+
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii)
+    ptcls.dp ("m", ii) = 2.;
+  ptcls.build_particle_mass ("m");
+  double total = 0.;
+  for (auto m : ptcls.mass ())
+    total += m;
+  ok = ok && std::abs (total - 2. * ptcls.num_particles)
+    <= 1e-9 * ptcls.num_particles;
+
+  // back to the geometric mass
+  ptcls.build_mass ();
+  ok = ok && ptcls.mass () == mass && ptcls.mass_prop.empty ();
+
+  std::cout << (ok ? "lumped masses are consistent"
+		: "lumped masses are not consistent") << std::endl;
+  return ok ? 0 : 1;
+};
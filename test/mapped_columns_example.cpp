@@ -0,0 +1,89 @@
+#include <mapped_resource.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (64, 64, 1./64., 1./64.);
+
+  constexpr idx_t num_particles = 500000;
+  std::vector<double> xv (num_particles), yv (num_particles);
+  std::mt19937 gen (5);
+  std::uniform_real_distribution<> dis (0.0, 1.0);
+  for (idx_t ii = 0; ii < num_particles; ++ii) {
+    xv[ii] = dis (gen);
+    yv[ii] = dis (gen);
+  }
+
+  // same particles, with columns on the heap and in files
+  // in the current directory
+  mapped_resource_t mr (argc > 1 ? argv[1] : ".");
+  particles_t heap (num_particles, {"label"}, {"m", "vx"}, grid, xv, yv);
+  particles_t mapped (num_particles, {"label"}, {"m", "vx"}, grid, xv, yv, &mr);
+
+  for (auto p : {&heap, &mapped}) {
+    p->dprops["m"].assign (num_particles, 1. / num_particles);
+    for (idx_t ii = 0; ii < num_particles; ++ii)
+      p->dp ("vx", ii) = p->x[ii] * p->y[ii];
+    p->build_mass ();
+  }
+
+  std::cout << "columns in " << mr.num_mappings () << " mapped files, "
+	    << mr.bytes_mapped () / (1 << 20) << " MiB" << std::endl;
+
+  std::map<std::string, std::vector<double>> vh, vm;
+  for (auto v : {&vh, &vm})
+    for (auto const & name : {"m", "vx"})
+      (*v)[name].assign (grid.num_global_nodes (), 0.);
+
+  heap.p2g (vh, {"m", "vx"}, {"m", "vx"}, true);
+  mapped.p2g (vm, {"m", "vx"}, {"m", "vx"}, true);
+  bool ok = vh == vm;
+
+  // gathers visit particles in cell order, not in memory order
+  mapped_resource_t::advise (mapped.dprops["vx"], mapped_resource_t::advice_t::random);
+  heap.g2p (vh, {"vx"}, {"vx"}, true, ASSIGNMENT_OPS::EQ);
+  mapped.g2p (vm, {"vx"}, {"vx"}, true, ASSIGNMENT_OPS::EQ);
+  ok = ok && heap.dprops["vx"] == mapped.dprops["vx"];
+
+  // a copy lives on the heap, as its resource says
+  const particles_t copy (mapped);
+  ok = ok && copy.resource == std::pmr::get_default_resource ()
+    && copy.x.get_allocator ().resource () == copy.resource
+    && copy.dprops.at ("vx").get_allocator ().resource () == copy.resource
+    && copy.iprops.at ("label").get_allocator ().resource () == copy.resource
+    && copy.x == mapped.x && copy.dprops == mapped.dprops
+    && copy.grd_to_ptcl == mapped.grd_to_ptcl
+    && copy.mass () == mapped.mass ();
+
+  // and a copy of the copy, moved, still holds all the state
+  particles_t again (copy);
+  const particles_t round_trip (std::move (again));
+  ok = ok && round_trip.resource == std::pmr::get_default_resource ()
+    && round_trip.x == mapped.x && round_trip.y == mapped.y
+    && round_trip.dprops == mapped.dprops
+    && round_trip.iprops == mapped.iprops
+    && round_trip.num_particles == mapped.num_particles
+    && round_trip.grd_to_ptcl == mapped.grd_to_ptcl
+    && round_trip.active_cells == mapped.active_cells
+    && round_trip.binning_version == mapped.binning_version
+    && round_trip.mass_hash == mapped.mass_hash
+    && round_trip.mass () == mapped.mass ()
+    && round_trip.inverse_mass () == mapped.inverse_mass ();
+
+  std::cout << (ok ? "mapped and heap columns give the same results"
+		: "mapped and heap columns differ") << std::endl;
+  return ok ? 0 : 1;
+};
@@ -0,0 +1,62 @@
+#include <numa_placement.h>
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  MPI_Init (&argc, &argv);
+  int rank = 0;
+  MPI_Comm_rank (MPI_COMM_WORLD, &rank);
+
+  // pin threads before anything is allocated, e.g. "scatter"
+  // on dual socket nodes; ranks on the same node get different cores
+  const auto cores = NUMA_PLACEMENT::pin_threads
+    (NUMA_PLACEMENT::affinity_from_string (argc > 1 ? argv[1] : "compact"));
+  std::cout << "rank " << rank << " threads pinned to cores";
+  for (auto ii : cores)
+    std::cout << " " << ii;
+  std::cout << std::endl;
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (128, 128, 1./128., 1./128.);
+
+  constexpr idx_t num_particles = 1000000;
+  NUMA_PLACEMENT::first_touch_resource_t ft;
+  particles_t heap (num_particles, {"label"}, {"m", "vx"}, grid);
+  particles_t ptcls (num_particles, {"label"}, {"m", "vx"}, grid, &ft);
+
+  bool ok = heap.x == ptcls.x && heap.y == ptcls.y
+    && heap.grd_to_ptcl == ptcls.grd_to_ptcl;
+
+  // grid fields placed by first touch as well
+  std::map<std::string, std::vector<double>> vh, vp;
+  for (auto v : {&vh, &vp})
+    for (auto const & name : {"m", "vx"}) {
+      NUMA_PLACEMENT::first_touch_reserve ((*v)[name], grid.num_global_nodes ());
+      (*v)[name].assign (grid.num_global_nodes (), 0.);
+    }
+
+  for (auto p : {&heap, &ptcls}) {
+    p->dprops["m"].assign (num_particles, 1. / num_particles);
+    for (idx_t ii = 0; ii < num_particles; ++ii)
+      p->dp ("vx", ii) = p->x[ii] - p->y[ii];
+    p->build_mass ();
+  }
+  heap.p2g (vh, {"m", "vx"}, {"m", "vx"}, true);
+  ptcls.p2g (vp, {"m", "vx"}, {"m", "vx"}, true);
+  ok = ok && vh == vp;
+
+  std::cout << (ok ? "first touch placement gives the same results"
+		: "first touch placement changes the results") << std::endl;
+  MPI_Finalize ();
+  return ok ? 0 : 1;
+};
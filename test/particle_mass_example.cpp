@@ -60,7 +60,7 @@ main (int argc, char *argv[]) {
   //   }
   // }
 
-  for (idx_t ip = 0; ip < ptcls.x.size (); ++ip) {
+  for (std::size_t ip = 0; ip < ptcls.x.size (); ++ip) {
     if (ptcls.x[ip] > .5) {
       ptcls.dprops["m"][ip] *= .1;
     }
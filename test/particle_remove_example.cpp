@@ -49,6 +49,14 @@ main (int argc, char *argv[]) {
   o2.open ("after_removal.octtxt", std::ios::out);
   ptcls.print<particles_t::output_format::octave_ascii> (o2);
   o2.close ();
+
+  // particles per cell around the hole left by the removal
+  ptcls.init_particle_mesh ();
+  auto diag = ptcls.density_diagnostics ();
+  std::cout << "density after removal : "
+	    << nlohmann::json (diag).dump () << std::endl;
+  grid.vtk_export ("after_removal.vts", {},
+		   {{"particles_per_cell", diag.counts}});
   
   return 0;
 };
@@ -0,0 +1,65 @@
+#include <particles.h>
+#include <philox.h>
+#include <quadgrid_cpp.h>
+
+#include <iostream>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  bool ok = true;
+
+  // known answer from the Philox4x32-10 reference implementation
+  const auto w = philox_t (0) (0, 0);
+  ok = ok && w[0] == 0x6627e8d5 && w[1] == 0xe169c58d
+    && w[2] == 0xbc57ac4c && w[3] == 0x9b00dbd8;
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (32, 64, 1./64., 1./32.);
+
+  constexpr idx_t num_particles = 1000000;
+  constexpr std::uint64_t seed = 1234;
+
+  particles_t all (num_particles, grid);
+  all.init_particle_positions (seed);
+
+  // same positions with a single thread
+#ifdef _OPENMP
+  const int nthreads = omp_get_max_threads ();
+  omp_set_num_threads (1);
+#endif
+  particles_t serial (num_particles, grid);
+  serial.init_particle_positions (seed);
+#ifdef _OPENMP
+  omp_set_num_threads (nthreads);
+#endif
+  ok = ok && serial.x == all.x && serial.y == all.y;
+
+  // and when split among "ranks", each passing its first global index
+  constexpr idx_t nparts = 3;
+  idx_t first = 0;
+  for (idx_t part = 0; part < nparts; ++part) {
+    const idx_t n = num_particles / nparts + (part < num_particles % nparts);
+    particles_t chunk (n, grid);
+    chunk.init_particle_positions (seed, first);
+    for (idx_t ii = 0; ii < n; ++ii)
+      ok = ok && chunk.x[ii] == all.x[first + ii] && chunk.y[ii] == all.y[first + ii];
+    first += n;
+  }
+
+  // the default generators follow the default seed
+  particles_t ptcls (10, {}, {}, grid);
+  for (idx_t ii = 0; ii < 10; ++ii)
+    ok = ok && ptcls.default_x_generator () == ptcls.x[ii]
+      && ptcls.default_y_generator () == ptcls.y[ii];
+
+  std::cout << (ok ? "seeding is reproducible" : "seeding differs") << std::endl;
+  return ok ? 0 : 1;
+};
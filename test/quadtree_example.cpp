@@ -0,0 +1,104 @@
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <quadtree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (8, 8, 1./8., 1./8.);
+
+  // dense blob on a sparse background
+  std::mt19937 gen (11);
+  std::normal_distribution<> blob (0.35, 0.04);
+  std::uniform_real_distribution<> background (0.0, 1.0);
+  idx_t count = 0;
+  constexpr idx_t num_particles = 40000;
+  auto coord = [&] () {
+    const double v = (count++ % 20 == 0) ? background (gen) : blob (gen);
+    return std::min (std::max (v, 0.0), 1.0 - 1.0e-12);
+  };
+
+  particles_t ptcls (num_particles, {"label"}, {"m", "f", "g"},
+		     grid, coord, coord);
+  ptcls.dprops["m"].assign (num_particles, 1. / num_particles);
+  for (idx_t ii = 0; ii < num_particles; ++ii)
+    ptcls.dp ("f", ii) = 1. + 2. * ptcls.x[ii] - 3. * ptcls.y[ii];
+
+  constexpr idx_t max_level = 4;
+  quadtree_t tree (grid, max_level);
+  tree.refine (ptcls, 64);
+  tree.build_mass ();
+
+  std::cout << "leaves " << tree.num_global_cells ()
+	    << ", nodes " << tree.num_global_nodes ()
+	    << " (" << tree.num_hanging_nodes () << " hanging)"
+	    << ", a uniform grid at the finest level would have "
+	    << (grid.num_global_cells () << (2 * max_level))
+	    << " cells" << std::endl;
+
+  bool ok = true;
+
+  // lumped mass sums up to the area of the domain
+  const double area = std::accumulate (tree.M.begin (), tree.M.end (), 0.);
+  ok = ok && std::abs (area - 1.) < 1.e-12;
+
+  // p2g conserves the total mass of particles
+  std::map<std::string, std::vector<double>> vars;
+  tree.p2g (ptcls, vars, {"m"}, {"m"});
+  const double mass = std::accumulate (vars["m"].begin (), vars["m"].end (), 0.);
+  ok = ok && std::abs (mass - 1.) < 1.e-12;
+
+  // g2p of a linear field is exact, also across hanging nodes
+  std::vector<double> lin (tree.num_global_nodes ());
+  for (auto icell = tree.begin_cell_sweep ();
+       icell != tree.end_cell_sweep (); ++icell)
+    for (idx_t k = 0; k < quadtree_t::nodes_per_cell; ++k)
+      lin[icell->gt (k)] = 1. + 2. * icell->p (0, k) - 3. * icell->p (1, k);
+  vars["f"] = lin;
+  tree.g2p (ptcls, vars, {"f"}, {"g"});
+  double err = 0.;
+  for (idx_t ii = 0; ii < num_particles; ++ii)
+    err = std::max (err, std::abs (ptcls.dp ("g", ii) - ptcls.dp ("f", ii)));
+  ok = ok && err < 1.e-12;
+
+  // deepest refinement of a wide grid, leaf coordinates beyond
+  // the range of 32 bit indices
+  {
+    quadgrid_t<std::vector<double>> wide;
+    wide.set_sizes (1, 4096, 1./4096., 1.);
+    particles_t corner (2, {}, {"m"}, wide);
+    corner.x.assign (2, 1. - 1.e-12);
+    corner.y.assign (2, .5);
+    corner.init_particle_mesh ();
+    quadtree_t deep (wide, 20);
+    deep.refine (corner, 1);
+    const quadtree_t::cell_t leaf (deep, deep.locate (corner.x[0], corner.y[0]));
+    ok = ok && leaf.level () == 20 && leaf.p (0, 3) == 1.
+      && leaf.p (0, 0) == 1. - std::ldexp (1., -32);
+    double leaf_area = 0.;
+    for (auto icell = deep.begin_cell_sweep ();
+	 icell != deep.end_cell_sweep (); ++icell)
+      leaf_area += (icell->p (0, 3) - icell->p (0, 0))
+	* (icell->p (1, 3) - icell->p (1, 0));
+    ok = ok && std::abs (leaf_area - 1.) < 1.e-12;
+  }
+
+  tree.p2g (ptcls, vars, {"f"}, {"f_p2g"}, true);
+  tree.vtk_export ("quadtree.vtu", vars);
+
+  std::cout << (ok ? "quadtree checks passed" : "quadtree checks failed")
+	    << std::endl;
+  return ok ? 0 : 1;
+};
@@ -0,0 +1,96 @@
+#include <particles.h>
+#include <quadgrid_cpp.h>
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (50, 80, 1./80., 1./50.);
+
+  // binning index against one built particle by particle
+  auto binned = [] (const particles_t & p) {
+    std::map<idx_t, std::vector<particles_t::bin_idx_t>> ref, bins;
+    for (idx_t ii = 0; ii < p.num_particles; ++ii)
+      ref[p.cell_index (p.x[ii], p.y[ii])].push_back (ii);
+    for (auto const & ii : p.grd_to_ptcl)
+      if (! ii.second.empty ())
+	bins.insert (ii);
+    return bins == ref;
+  };
+
+  bool ok = true;
+  particles_t ptcls (0, {"label"}, {"m"}, grid);
+
+  // 4 x 4 particles per cell on a lattice
+  ptcls.seed_cells (4, 4);
+  ok = ok && ptcls.num_particles == 16 * grid.num_global_cells ()
+    && ptcls.dprops["m"].size () == ptcls.x.size ();
+
+  // jittered, only inside a disc
+  auto inside = [] (double x, double y) {
+    return (x - .5) * (x - .5) + (y - .5) * (y - .5) < .3 * .3;
+  };
+  ptcls.seed_cells (3, 3, particles_t::seeding_t::jittered, inside, 42);
+  for (idx_t ii = 0; ii < ptcls.num_particles; ++ii)
+    ok = ok && inside (ptcls.x[ii], ptcls.y[ii]);
+
+  // particles are grouped by cell and the binning index matches
+  // the one built from scratch
+  idx_t next = 0;
+  for (auto const & ii : ptcls.grd_to_ptcl)
+    for (auto idx : ii.second)
+      ok = ok && idx == next++;
+  auto const seeded = ptcls.grd_to_ptcl;
+  auto const active = ptcls.active_cells;
+  ptcls.init_particle_mesh ();
+  ok = ok && seeded == ptcls.grd_to_ptcl && active == ptcls.active_cells
+    && binned (ptcls);
+
+  // at least one particle per cell in each direction
+  for (auto n : {0, -2}) {
+    try {
+      ptcls.seed_cells (n, 3);
+      ok = false;
+    }
+    catch (const std::invalid_argument &) { }
+    try {
+      ptcls.seed_cells (3, n);
+      ok = false;
+    }
+    catch (const std::invalid_argument &) { }
+  }
+
+  // particles on the right boundary and outside the grid are binned
+  // but only cells of the grid are active, and only the particle
+  // inside contributes to the nodes
+  particles_t edge (3, {}, {"m"}, grid);
+  edge.x.assign ({.5, 1., 1.5});
+  edge.y.assign ({.5, .5, .2});
+  edge.dprops["m"].assign (3, 1.);
+  edge.init_particle_mesh ();
+  ok = ok && binned (edge);
+  for (auto gidx : edge.active_cells)
+    ok = ok && gidx >= 0 && gidx < grid.num_global_cells ();
+  std::map<std::string, std::vector<double>>
+    vars{{"m", std::vector<double> (grid.num_global_nodes (), 0.)}};
+  edge.p2g (vars);
+  double mtot = 0.;
+  for (auto ii : vars["m"])
+    mtot += ii;
+  ok = ok && edge.active_cells.size () == 1 && std::abs (mtot - 1.) < 1.e-12;
+
+  std::cout << ptcls.num_particles << " particles in "
+	    << ptcls.active_cells.size () << " cells" << std::endl;
+  std::cout << (ok ? "seeded particles are binned"
+		: "seeded particles are not binned correctly") << std::endl;
+  return ok ? 0 : 1;
+};
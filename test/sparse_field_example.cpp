@@ -0,0 +1,79 @@
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <sparse_field.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (512, 512, 1./512., 1./512.);
+
+  // particles in a small blob, most of the domain is empty
+  std::mt19937 gen (7);
+  std::normal_distribution<> blob (0.3, 0.02);
+  auto coord = [&] () {
+    return std::min (std::max (blob (gen), 0.0), 1.0 - 1.0e-12);
+  };
+
+  constexpr idx_t num_particles = 100000;
+  particles_t ptcls (num_particles, {"label"}, {"m", "vx", "q"},
+		     grid, coord, coord);
+  ptcls.dprops["m"].assign (num_particles, 1. / num_particles);
+  for (idx_t ii = 0; ii < num_particles; ++ii)
+    ptcls.dp ("vx", ii) = std::sin (ptcls.x[ii]);
+  ptcls.build_mass ();
+
+  std::map<std::string, std::vector<double>>
+    dense{{"m", std::vector<double>(grid.num_global_nodes (), 0.)},
+	  {"vx", std::vector<double>(grid.num_global_nodes (), 0.)}};
+
+  std::map<std::string, sparse_field_t>
+    sparse{{"m", sparse_field_t (grid)}, {"vx", sparse_field_t (grid)}};
+
+  ptcls.p2g (dense, {"m", "vx"}, {"m", "vx"}, true);
+  ptcls.p2g (sparse, {"m", "vx"}, {"m", "vx"}, true);
+
+  bool ok = true;
+  for (auto const & ii : dense)
+    ok = ok && (sparse.at (ii.first).to_dense () == ii.second);
+
+  particles_t::dcolumn_t qd, qs;
+  ptcls.g2p (dense, {"vx"}, {"q"}, false, ASSIGNMENT_OPS::EQ);
+  qd = ptcls.dprops["q"];
+  ptcls.g2p (sparse, {"vx"}, {"q"}, false, ASSIGNMENT_OPS::EQ);
+  qs = ptcls.dprops["q"];
+  ok = ok && (qd == qs);
+
+  auto const & f = sparse.at ("m");
+  std::cout << "tiles allocated " << f.num_allocated_tiles ()
+	    << " of " << f.num_tiles () << std::endl;
+
+  // tiles are recycled from the pool in the next step
+  for (auto & ii : sparse)
+    ii.second.clear ();
+  ptcls.p2g (sparse, {"m", "vx"}, {"m", "vx"}, true);
+  ok = ok && (sparse.at ("m").to_dense () == dense.at ("m"));
+  std::cout << "tiles in pool after reuse " << f.num_pooled_tiles ()
+	    << std::endl;
+
+  memory_report_t r;
+  for (auto const & ii : sparse)
+    ii.second.memory_report (r, ii.first);
+  std::cout << r;
+
+  grid.vtk_export ("sparse_field.vts", sparse);
+
+  std::cout << (ok ? "sparse and dense transfers match"
+		: "sparse and dense transfers differ") << std::endl;
+  return ok ? 0 : 1;
+};
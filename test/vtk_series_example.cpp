@@ -0,0 +1,64 @@
+#include <particles.h>
+#include <quadgrid_cpp.h>
+#include <vtk_series.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using idx_t = quadgrid_t<std::vector<double>>::idx_t;
+
+int
+main (int argc, char *argv[]) {
+
+  quadgrid_t<std::vector<double>> grid;
+  grid.set_sizes (20, 40, 1./40., 1./20.);
+
+  constexpr idx_t num_particles = 100000;
+  particles_t ptcls (num_particles, {"label"}, {"m", "vx", "vy"}, grid);
+  ptcls.dprops["m"].assign (num_particles, 1. / num_particles);
+  ptcls.dprops["vx"].assign (num_particles, .1);
+
+  std::map<std::string, std::vector<double>>
+    vars{{"m0", std::vector<double>(grid.num_global_nodes (), 0.)},
+	 {"vx", std::vector<double>(grid.num_global_nodes (), 0.)}};
+
+  // initial mass distribution does not change, it is written only once
+  ptcls.p2g (vars, {"m"}, {"m0"});
+
+  // write only one particle every 10
+  vtk_series_t series ("vtk_series_example", grid, 10);
+
+  constexpr double dt = .1;
+  for (idx_t step = 0; step < 5; ++step) {
+
+    std::fill (vars["vx"].begin (), vars["vx"].end (), 0.);
+    ptcls.p2g (vars, {"vx"}, {"vx"});
+
+    series.write_step (step * dt, vars, ptcls, {"vx"}, {});
+
+    for (idx_t ip = 0; ip < num_particles; ++ip)
+      ptcls.x[ip] = std::min (ptcls.x[ip] + dt * ptcls.dp ("vx", ip), .999);
+    ptcls.init_particle_mesh ();
+    for (auto & v : ptcls.dprops["vx"])
+      v *= 1.1;
+  }
+
+  std::cout << series.num_steps () << " steps, "
+	    << series.num_files_written () << " files written" << std::endl;
+
+  // only changes to the particles that are written cause a new file
+  series.write_step (5 * dt, vars, ptcls, {"vx"}, {});
+  const std::size_t files = series.num_files_written ();
+  ptcls.dp ("vx", 1) += 1.;
+  series.write_step (6 * dt, vars, ptcls, {"vx"}, {});
+  bool ok = series.num_files_written () == files;
+  ptcls.dp ("vx", 10) += 1.;
+  series.write_step (7 * dt, vars, ptcls, {"vx"}, {});
+  ok = ok && series.num_files_written () == files + 1;
+
+  std::cout << (ok ? "unchanged parts are not written again"
+		: "unchanged parts are written again") << std::endl;
+  return ok ? 0 : 1;
+};